@@ -44,6 +44,7 @@ Done:
 #include <array>
 #include <cmath>
 #include <map>
+#include <memory>
 #include <numeric>
 #include <set>
 #include <string>
@@ -53,7 +54,26 @@ Done:
 #include <vector>
 #include <list>
 #include <deque>
+#include <initializer_list>
+#include <iterator>
 #include <cstdint>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <tuple>
+#include <limits>
+#if __cplusplus >= 201703L
+  #include <string_view>
+  #include <charconv>
+  #include <optional>
+#endif
 
 // Configuration
 #ifndef UNDERSCORE_ASSERT
@@ -68,6 +88,46 @@ Done:
   #define UNDERSCORE_STATIC_ASSERT static_assert
 #endif
 
+#ifndef UNDERSCORE_SSE2
+  #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define UNDERSCORE_SSE2 1
+  #else
+    #define UNDERSCORE_SSE2 0
+  #endif
+#endif
+#if UNDERSCORE_SSE2
+  #include <emmintrin.h>
+#endif
+
+#ifndef UNDERSCORE_LITTLE_ENDIAN
+  #if defined(_WIN32) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    #define UNDERSCORE_LITTLE_ENDIAN 1
+  #else
+    #define UNDERSCORE_LITTLE_ENDIAN 0
+  #endif
+#endif
+
+#ifndef UNDERSCORE_MMAP // set to 0 to build mmap_file without OS mappings (is_open() stays false) and without <windows.h>
+  #define UNDERSCORE_MMAP 1
+#endif
+
+#if defined(_WIN32)
+  #if UNDERSCORE_MMAP
+    #ifndef NOMINMAX
+      #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+      #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+  #endif
+#elif defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
 // C++14 backwards compatibility
 #define UNDERSCORE_CBEGIN(container)  container.begin()
 #define UNDERSCORE_CEND(container)    container.end()
@@ -176,6 +236,116 @@ namespace UnderscoreDetail {
     const static bool value = true;
   };
 
+  // has_allocator
+  template <typename ContainerType>
+  struct has_allocator {
+    template <typename T> static char test(typename T::allocator_type*);
+    template <typename T> static long test(...);
+    const static bool value = sizeof(test<ContainerType>(0)) == sizeof(char);
+  };
+
+  // allocator_for - the allocator of a container rebound to ValueType, or std::allocator if the container has none
+  template <typename ContainerType, typename ValueType, bool HasAllocator = has_allocator<ContainerType>::value>
+  struct allocator_for {
+    typedef std::allocator<ValueType> type;
+    static type get(const ContainerType&) { return type(); }
+  };
+  template <typename ContainerType, typename ValueType>
+  struct allocator_for<ContainerType, ValueType, true> {
+    typedef typename std::allocator_traits<typename ContainerType::allocator_type>::template rebind_alloc<ValueType> type;
+    static type get(const ContainerType& container) { return type(container.get_allocator()); }
+  };
+
+  // make_empty_like - an empty container sharing the allocator of the source container
+  template <typename ContainerType>
+  ContainerType
+  make_empty_like_impl(const ContainerType& container, std::true_type) {
+    return ContainerType(container.get_allocator());
+  }
+  template <typename ContainerType>
+  ContainerType
+  make_empty_like_impl(const ContainerType&, std::false_type) {
+    return ContainerType();
+  }
+  template <typename ContainerType, bool HasAllocator = has_allocator<ContainerType>::value>
+  struct is_allocator_constructible : std::false_type {};
+  template <typename ContainerType>
+  struct is_allocator_constructible<ContainerType, true>
+  : std::integral_constant<bool, std::is_constructible<ContainerType, const typename ContainerType::allocator_type&>::value> {};
+  template <typename ContainerType>
+  ContainerType
+  make_empty_like(const ContainerType& container) {
+    return make_empty_like_impl(container, is_allocator_constructible<ContainerType>());
+  }
+
+  // rebind_container - the same kind of container using AllocatorType, std::vector for containers without allocators
+  template <typename ContainerType, typename AllocatorType>
+  struct rebind_container {
+    typedef typename ContainerType::value_type value_type;
+    typedef std::vector<value_type, typename std::allocator_traits<AllocatorType>::template rebind_alloc<value_type> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, typename type::allocator_type(allocator));
+    }
+  };
+  template <typename ValueType, typename AllocType, typename AllocatorType>
+  struct rebind_container<std::deque<ValueType, AllocType>, AllocatorType> {
+    typedef std::deque<ValueType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<ValueType> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, typename type::allocator_type(allocator));
+    }
+  };
+  template <typename ValueType, typename AllocType, typename AllocatorType>
+  struct rebind_container<std::list<ValueType, AllocType>, AllocatorType> {
+    typedef std::list<ValueType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<ValueType> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, typename type::allocator_type(allocator));
+    }
+  };
+  template <typename CharType, typename TraitsType, typename AllocType, typename AllocatorType>
+  struct rebind_container<std::basic_string<CharType, TraitsType, AllocType>, AllocatorType> {
+    typedef std::basic_string<CharType, TraitsType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<CharType> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, typename type::allocator_type(allocator));
+    }
+  };
+  template <typename ValueType, typename CompareType, typename AllocType, typename AllocatorType>
+  struct rebind_container<std::set<ValueType, CompareType, AllocType>, AllocatorType> {
+    typedef std::set<ValueType, CompareType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<ValueType> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, CompareType(), typename type::allocator_type(allocator));
+    }
+  };
+  template <typename ValueType, typename CompareType, typename AllocType, typename AllocatorType>
+  struct rebind_container<std::multiset<ValueType, CompareType, AllocType>, AllocatorType> {
+    typedef std::multiset<ValueType, CompareType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<ValueType> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, CompareType(), typename type::allocator_type(allocator));
+    }
+  };
+  template <typename ValueType, typename HashType, typename EqualType, typename AllocType, typename AllocatorType>
+  struct rebind_container<std::unordered_set<ValueType, HashType, EqualType, AllocType>, AllocatorType> {
+    typedef std::unordered_set<ValueType, HashType, EqualType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<ValueType> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, 0, HashType(), EqualType(), typename type::allocator_type(allocator));
+    }
+  };
+  template <typename KeyType, typename ValueType, typename CompareType, typename AllocType, typename AllocatorType>
+  struct rebind_container<std::map<KeyType, ValueType, CompareType, AllocType>, AllocatorType> {
+    typedef std::pair<const KeyType, ValueType> pair_type;
+    typedef std::map<KeyType, ValueType, CompareType, typename std::allocator_traits<AllocatorType>::template rebind_alloc<pair_type> > type;
+    template <typename IteratorType>
+    static type make(IteratorType first, IteratorType last, const AllocatorType& allocator) {
+      return type(first, last, CompareType(), typename type::allocator_type(allocator));
+    }
+  };
+
   // find_first_not_of
   template <typename IteratorType0, typename IteratorType1>
   IteratorType0
@@ -548,12 +718,76 @@ PIPE_OPERATOR(ContainerType& container, const UnderscoreTags::BeginTag&) {
   return std::begin(container);
 }
 
-/// binary_search - stl
+/// branchless_lower_bound, branchless_upper_bound
+namespace UnderscoreDetail {
+  struct less_than {
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const { return a < b; }
+  };
+
+  // branchless_lower_bound - binary search where the only data dependency is a conditional move
+  template <typename IteratorType, typename ValueType, typename CompareType>
+  IteratorType
+  branchless_lower_bound(IteratorType first, IteratorType last, const ValueType& value, CompareType compare) {
+    auto length = last - first;
+    if (length == 0)
+      return first;
+    while (length > 1) {
+      const auto half = length / 2;
+      first = compare(first[half], value) ? first + half : first;
+      length -= half;
+    }
+    return compare(*first, value) ? first + 1 : first;
+  }
+  template <typename IteratorType, typename ValueType, typename CompareType>
+  IteratorType
+  branchless_upper_bound(IteratorType first, IteratorType last, const ValueType& value, CompareType compare) {
+    auto length = last - first;
+    if (length == 0)
+      return first;
+    while (length > 1) {
+      const auto half = length / 2;
+      first = compare(value, first[half]) ? first : first + half;
+      length -= half;
+    }
+    return compare(value, *first) ? first : first + 1;
+  }
+
+  // sorted_lower_bound, sorted_upper_bound - branchless for random access iterators, the stl search otherwise
+  template <typename IteratorType, typename ValueType>
+  IteratorType sorted_lower_bound(IteratorType first, IteratorType last, const ValueType& value, std::random_access_iterator_tag) {
+    return branchless_lower_bound(first, last, value, less_than());
+  }
+  template <typename IteratorType, typename ValueType>
+  IteratorType sorted_lower_bound(IteratorType first, IteratorType last, const ValueType& value, std::forward_iterator_tag) {
+    return std::lower_bound(first, last, value);
+  }
+  template <typename IteratorType, typename ValueType>
+  IteratorType sorted_lower_bound(IteratorType first, IteratorType last, const ValueType& value) {
+    return sorted_lower_bound(first, last, value, typename std::iterator_traits<IteratorType>::iterator_category());
+  }
+  template <typename IteratorType, typename ValueType>
+  IteratorType sorted_upper_bound(IteratorType first, IteratorType last, const ValueType& value, std::random_access_iterator_tag) {
+    return branchless_upper_bound(first, last, value, less_than());
+  }
+  template <typename IteratorType, typename ValueType>
+  IteratorType sorted_upper_bound(IteratorType first, IteratorType last, const ValueType& value, std::forward_iterator_tag) {
+    return std::upper_bound(first, last, value);
+  }
+  template <typename IteratorType, typename ValueType>
+  IteratorType sorted_upper_bound(IteratorType first, IteratorType last, const ValueType& value) {
+    return sorted_upper_bound(first, last, value, typename std::iterator_traits<IteratorType>::iterator_category());
+  }
+}
+
+/// binary_search
 CREATE_TAG_1_ARG( BinarySearchTag );
 template <typename ContainerType, typename ArgType0>
 bool
 PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::BinarySearchTag1Arg<ArgType0>& tag) {
-  return std::binary_search(std::begin(container), std::end(container), tag.arg0);
+  const auto& last = std::end(container);
+  const auto& it = UnderscoreDetail::sorted_lower_bound(std::begin(container), last, tag.arg0);
+  return it != last && !(tag.arg0 < *it);
 }
 
 /// cbegin - stl
@@ -791,13 +1025,212 @@ PIPE_OPERATOR(TupleType&& tpl, const UnderscoreTags::GetTag<TupleIndex>&) {
   return std::get<TupleIndex>(tpl);
 }
 
-/// hash - stl
-CREATE_TAG_0_ARG( HashTag );
+/// hash, hash_combine
+namespace UnderscoreDetail {
+  // is_iterable - has a value_type and can be iterated with std::begin
+  template <typename T>
+  struct is_iterable {
+    template <typename U> static char test(typename U::value_type*, decltype(std::begin(std::declval<const U&>()))*);
+    template <typename U> static long test(...);
+    const static bool value = sizeof(test<T>(0, 0)) == sizeof(char);
+  };
+  // is_contiguous_container - elements are stored in one array starting at the first element
+  template <typename ContainerType>
+  struct is_contiguous_container : std::false_type {};
+  template <typename T, typename AllocType>
+  struct is_contiguous_container<std::vector<T, AllocType> > : std::integral_constant<bool, !std::is_same<T, bool>::value> {};
+  template <typename CharType, typename TraitsType, typename AllocType>
+  struct is_contiguous_container<std::basic_string<CharType, TraitsType, AllocType> > : std::true_type {};
+  template <typename T, size_t N>
+  struct is_contiguous_container<std::array<T, N> > : std::true_type {};
+#if __cplusplus >= 201703L
+  template <typename CharType, typename TraitsType>
+  struct is_contiguous_container<std::basic_string_view<CharType, TraitsType> > : std::true_type {};
+#endif
+  // has_hasher - unordered containers, whose iteration order says nothing about equality
+  template <typename ContainerType>
+  struct has_hasher {
+    template <typename T> static char test(typename T::hasher*);
+    template <typename T> static long test(...);
+    const static bool value = sizeof(test<ContainerType>(0)) == sizeof(char);
+  };
+
+  // multiply_fold - the 128 bit product of a and b folded to 64 bits, the mixing step of wyhash
+  inline void multiply_128(uint64_t& low, uint64_t& high) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128_type;
+    const uint128_type product = static_cast<uint128_type>(low) * high;
+    low = static_cast<uint64_t>(product);
+    high = static_cast<uint64_t>(product >> 64);
+#else
+    const uint64_t low_low = (low & 0xffffffff) * (high & 0xffffffff);
+    const uint64_t high_low = (low >> 32) * (high & 0xffffffff);
+    const uint64_t low_high = (low & 0xffffffff) * (high >> 32);
+    const uint64_t high_high = (low >> 32) * (high >> 32);
+    const uint64_t middle = (low_low >> 32) + (high_low & 0xffffffff) + low_high;
+    low = (middle << 32) | (low_low & 0xffffffff);
+    high = high_high + (high_low >> 32) + (middle >> 32);
+#endif
+  }
+  inline uint64_t multiply_fold(uint64_t a, uint64_t b) {
+    multiply_128(a, b);
+    return a ^ b;
+  }
+  const uint64_t hash_secret0 = 0x2d358dccaa6c78a5ULL;
+  const uint64_t hash_secret1 = 0x8bb84b93962eacc9ULL;
+  const uint64_t hash_secret2 = 0x4b33a62ed433d4a3ULL;
+  const uint64_t hash_secret3 = 0x4d5a2da51de1aa47ULL;
+  inline uint64_t hash_read8(const uint8_t* bytes) {
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+  inline uint64_t hash_read4(const uint8_t* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+  // wyhash - inputs over 48 bytes are consumed by three independent multiply lanes, which keeps several
+  // 64 bit multipliers busy per cycle. Reads are native endian, hashes are stable on little endian machines.
+  inline uint64_t wyhash(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    seed ^= multiply_fold(seed ^ hash_secret0, hash_secret1);
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (size <= 16) {
+      if (size >= 4) {
+        a = (hash_read4(bytes) << 32) | hash_read4(bytes + ((size >> 3) << 2));
+        b = (hash_read4(bytes + size - 4) << 32) | hash_read4(bytes + size - 4 - ((size >> 3) << 2));
+      }
+      else if (size > 0)
+        a = (static_cast<uint64_t>(bytes[0]) << 16) | (static_cast<uint64_t>(bytes[size >> 1]) << 8) | bytes[size - 1];
+    }
+    else {
+      size_t remaining = size;
+      if (remaining > 48) {
+        uint64_t lane1 = seed;
+        uint64_t lane2 = seed;
+        do {
+          seed = multiply_fold(hash_read8(bytes) ^ hash_secret1, hash_read8(bytes + 8) ^ seed);
+          lane1 = multiply_fold(hash_read8(bytes + 16) ^ hash_secret2, hash_read8(bytes + 24) ^ lane1);
+          lane2 = multiply_fold(hash_read8(bytes + 32) ^ hash_secret3, hash_read8(bytes + 40) ^ lane2);
+          bytes += 48;
+          remaining -= 48;
+        } while (remaining > 48);
+        seed ^= lane1 ^ lane2;
+      }
+      for (; remaining > 16; remaining -= 16, bytes += 16)
+        seed = multiply_fold(hash_read8(bytes) ^ hash_secret1, hash_read8(bytes + 8) ^ seed);
+      a = hash_read8(bytes + remaining - 16);
+      b = hash_read8(bytes + remaining - 8);
+    }
+    a ^= hash_secret1;
+    b ^= seed;
+    multiply_128(a, b);
+    return multiply_fold(a ^ hash_secret0 ^ size, b ^ hash_secret1);
+  }
+  inline uint64_t hash_combine(uint64_t seed, uint64_t hash) {
+    return multiply_fold(seed ^ hash_secret0, hash ^ hash_secret1);
+  }
+
+  // hash_value - integers and floats are mixed, contiguous integer arrays and strings hashed as bytes,
+  // pairs, tuples and containers chained element by element and unordered containers summed so the
+  // iteration order does not matter. Other types go through std::hash.
+  enum hash_kind { hash_scalar, hash_bytes, hash_ordered, hash_unordered, hash_std };
+  template <typename T, bool IsIterable = is_iterable<T>::value>
+  struct hash_kind_of : std::integral_constant<int, std::is_arithmetic<T>::value || std::is_enum<T>::value ? hash_scalar : hash_std> {};
+  template <typename T>
+  struct hash_kind_of<T, true> : std::integral_constant<int,
+    is_contiguous_container<T>::value && std::is_integral<typename T::value_type>::value ? hash_bytes :
+    has_hasher<T>::value ? hash_unordered : hash_ordered> {};
+
+  template <typename T>
+  uint64_t hash_value(const T& value, uint64_t seed);
+  template <typename FirstType, typename SecondType>
+  uint64_t hash_value(const std::pair<FirstType, SecondType>& value, uint64_t seed);
+  template <typename... Types>
+  uint64_t hash_value(const std::tuple<Types...>& value, uint64_t seed);
+
+  template <typename T>
+  uint64_t hash_scalar_bits(const T& value, std::false_type /*is_floating_point*/) { return static_cast<uint64_t>(value); }
+  template <typename T>
+  uint64_t hash_scalar_bits(const T& value, std::true_type /*is_floating_point*/) {
+    const double normalized = value == 0 ? 0.0 : static_cast<double>(value); // -0.0 == 0.0
+    uint64_t bits;
+    std::memcpy(&bits, &normalized, sizeof(bits));
+    return bits;
+  }
+  template <typename T>
+  uint64_t hash_value(const T& value, uint64_t seed, std::integral_constant<int, hash_scalar>) {
+    return multiply_fold(hash_scalar_bits(value, std::is_floating_point<T>()) ^ hash_secret1, seed ^ hash_secret0);
+  }
+  template <typename T>
+  uint64_t hash_value(const T& value, uint64_t seed, std::integral_constant<int, hash_bytes>) {
+    const size_t size = static_cast<size_t>(std::distance(std::begin(value), std::end(value)));
+    return wyhash(size == 0 ? nullptr : std::addressof(*std::begin(value)), size * sizeof(typename T::value_type), seed);
+  }
+  template <typename T>
+  uint64_t hash_value(const T& value, uint64_t seed, std::integral_constant<int, hash_ordered>) {
+    uint64_t hash = seed;
+    uint64_t count = 0;
+    for (auto it = std::begin(value); it != std::end(value); ++it, ++count)
+      hash = hash_value(*it, hash);
+    return hash_combine(hash, count);
+  }
+  template <typename T>
+  uint64_t hash_value(const T& value, uint64_t seed, std::integral_constant<int, hash_unordered>) {
+    uint64_t sum = 0;
+    uint64_t count = 0;
+    for (auto it = std::begin(value); it != std::end(value); ++it, ++count)
+      sum += hash_value(*it, seed);
+    return hash_combine(seed ^ count, sum);
+  }
+  template <typename T>
+  uint64_t hash_value(const T& value, uint64_t seed, std::integral_constant<int, hash_std>) {
+    return multiply_fold(static_cast<uint64_t>(std::hash<T>()(value)) ^ hash_secret1, seed ^ hash_secret0);
+  }
+  template <typename T>
+  uint64_t hash_value(const T& value, uint64_t seed) {
+    return hash_value(value, seed, std::integral_constant<int, hash_kind_of<T>::value>());
+  }
+  template <typename FirstType, typename SecondType>
+  uint64_t hash_value(const std::pair<FirstType, SecondType>& value, uint64_t seed) {
+    return hash_value(value.second, hash_value(value.first, seed));
+  }
+  template <typename TupleType>
+  uint64_t hash_tuple(const TupleType&, uint64_t seed, std::integral_constant<size_t, 0>) { return seed; }
+  template <typename TupleType, size_t Remaining>
+  uint64_t hash_tuple(const TupleType& value, uint64_t seed, std::integral_constant<size_t, Remaining>) {
+    const size_t idx = std::tuple_size<TupleType>::value - Remaining;
+    return hash_tuple(value, hash_value(std::get<idx>(value), seed), std::integral_constant<size_t, Remaining - 1>());
+  }
+  template <typename... Types>
+  uint64_t hash_value(const std::tuple<Types...>& value, uint64_t seed) {
+    return hash_tuple(value, seed, std::integral_constant<size_t, sizeof...(Types)>());
+  }
+
+  // fast_hash - hash_value as a hash functor, the default hasher of hash_set and hash_map
+  template <typename T>
+  struct fast_hash {
+    size_t operator()(const T& value) const { return static_cast<size_t>(hash_value(value, 0)); }
+  };
+}
+CREATE_TAG_0_1_ARG( HashTag );
 template <typename ValueType>
 size_t
 PIPE_OPERATOR(const ValueType& value, const UnderscoreTags::HashTag&) {
-  const std::hash<ValueType> hasher;
-  return hasher(value);
+  return static_cast<size_t>(UnderscoreDetail::hash_value(value, 0));
+}
+template <typename ValueType, typename SeedType> // seed
+size_t
+PIPE_OPERATOR(const ValueType& value, const UnderscoreTags::HashTag1Arg<SeedType>& tag) {
+  return static_cast<size_t>(UnderscoreDetail::hash_value(value, static_cast<uint64_t>(tag.arg0)));
+}
+CREATE_TAG_1_ARG( HashCombineTag );
+template <typename ValueType, typename HashType> // the hash the hash of value is combined with
+size_t
+PIPE_OPERATOR(const ValueType& value, const UnderscoreTags::HashCombineTag1Arg<HashType>& tag) {
+  return static_cast<size_t>(UnderscoreDetail::hash_combine(static_cast<uint64_t>(tag.arg0), UnderscoreDetail::hash_value(value, 0)));
 }
 
 /// includes
@@ -845,13 +1278,13 @@ template <typename ContainerType, typename ArgType0> // immutable
 typename ContainerType::const_iterator
 PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::LowerBoundTag1Arg<ArgType0>& tag) {
   UNDERSCORE_STATIC_ASSERT(std::is_rvalue_reference<ContainerType>::value == false, "");
-  return std::lower_bound(std::begin(container), std::end(container), tag.arg0);
+  return UnderscoreDetail::sorted_lower_bound(std::begin(container), std::end(container), tag.arg0);
 }
 template <typename ContainerType, typename ArgType0> // mutable
 typename ContainerType::iterator
 PIPE_OPERATOR(ContainerType& container, const UnderscoreTags::LowerBoundTag1Arg<ArgType0>& tag) {
   UNDERSCORE_STATIC_ASSERT(std::is_rvalue_reference<ContainerType>::value == false, "");
-  return std::lower_bound(std::begin(container), std::end(container), tag.arg0);
+  return UnderscoreDetail::sorted_lower_bound(std::begin(container), std::end(container), tag.arg0);
 }
 
 /// max_element
@@ -965,25 +1398,22 @@ PIPE_OPERATOR(const IteratorType& iterator, const UnderscoreTags::PrevTag1Arg<Di
   return std::prev(iterator, tag.arg0);
 }
 
-/// upper_bound - stl
+/// upper_bound
 CREATE_TAG_1_ARG( UpperBoundTag );
 template <typename ContainerType, typename ArgType0> // immutable
 typename ContainerType::const_iterator
 PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::UpperBoundTag1Arg<ArgType0>& tag) {
   UNDERSCORE_STATIC_ASSERT(std::is_rvalue_reference<ContainerType>::value == false, "");
-  return std::upper_bound(std::begin(container), std::end(container), tag.arg0);
+  return UnderscoreDetail::sorted_upper_bound(std::begin(container), std::end(container), tag.arg0);
 }
 template <typename ContainerType, typename ArgType0> // mutable
 typename ContainerType::iterator
 PIPE_OPERATOR(ContainerType& container, const UnderscoreTags::UpperBoundTag1Arg<ArgType0>& tag) {
   UNDERSCORE_STATIC_ASSERT(std::is_rvalue_reference<ContainerType>::value == false, "");
-  return std::upper_bound(std::begin(container), std::end(container), tag.arg0);
+  return UnderscoreDetail::sorted_upper_bound(std::begin(container), std::end(container), tag.arg0);
 }
 
 // Todo..
-// set_intersection
-// set_union
-// set_...
 // mismatch
 // transform
 
@@ -1015,14 +1445,22 @@ namespace UnderscoreTags {
 template <template <typename, typename> class ContainerType, typename ValueType, typename AllocType, typename FunctorType>
 ContainerType <
   typename std::result_of<FunctorType(ValueType)>::type, 
-  std::allocator<typename std::result_of<FunctorType(ValueType)>::type> >
+  typename std::allocator_traits<AllocType>::template rebind_alloc<typename std::result_of<FunctorType(ValueType)>::type> >
 PIPE_OPERATOR(const ContainerType<ValueType, AllocType>& container, const UnderscoreTags::TransformTag1Arg<FunctorType>& tag) {
   typedef typename std::result_of<FunctorType(ValueType)>::type ResultType;
-  typedef ContainerType<ResultType, std::allocator<ResultType> > ResultContainerType;
-  ResultContainerType result_container(container.size());
+  typedef typename std::allocator_traits<AllocType>::template rebind_alloc<ResultType> ResultAllocType;
+  typedef ContainerType<ResultType, ResultAllocType> ResultContainerType;
+  ResultContainerType result_container(container.size(), ResultType(), ResultAllocType(container.get_allocator()));
   std::transform(std::begin(container), std::end(container), std::begin(result_container), tag.arg0);
   return result_container;
 }
+template <typename RangeType, typename FunctorType> // other ranges, such as views, transform into a vector
+std::vector<typename std::decay<typename std::result_of<FunctorType(typename RangeType::value_type)>::type>::type>
+PIPE_OPERATOR(const RangeType& range, const UnderscoreTags::TransformTag1Arg<FunctorType>& tag) {
+  std::vector<typename std::decay<typename std::result_of<FunctorType(typename RangeType::value_type)>::type>::type> result;
+  std::transform(std::begin(range), std::end(range), std::back_inserter(result), tag.arg0);
+  return result;
+}
 
 // transform_to
 namespace UnderscoreTags {
@@ -1144,13 +1582,14 @@ PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TransformTag
 
 #define CREATE_TO_SPECIFIC_CONTAINER_PIPE(TAG_NAME, CONTAINER_NAME) \
   template <typename ContainerType> \
-  CONTAINER_NAME<typename ContainerType::value_type> \
+  CONTAINER_NAME<typename ContainerType::value_type, typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type> \
   PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TAG_NAME&) { \
-    return CONTAINER_NAME<typename ContainerType::value_type>(std::begin(container), std::end(container)); \
+    typedef UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type> AllocatorFor; \
+    return CONTAINER_NAME<typename ContainerType::value_type, typename AllocatorFor::type>(std::begin(container), std::end(container), AllocatorFor::get(container)); \
   } \
   template <typename ContainerType, typename PreallocatedContainer>  \
-  CONTAINER_NAME<typename ContainerType::value_type>  \
-  PIPE_OPERATOR(const ContainerType& container, UnderscoreTags::TAG_NAME##1Arg<PreallocatedContainer>& tag) { \
+  PreallocatedContainer  \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TAG_NAME##1Arg<PreallocatedContainer>& tag) { \
     tag.arg0.assign(std::begin(container), std::end(container)); \
     return tag.arg0; \
   } /*
@@ -1174,9 +1613,28 @@ PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TransformTag
 #define CREATE_TO_SPECIFIC_SET_PIPE(TAG_NAME, CONTAINER_NAME) \
   CREATE_TAG_0_ARG( TAG_NAME ); \
   template <typename ContainerType> \
-  CONTAINER_NAME<typename ContainerType::value_type> \
+  CONTAINER_NAME< \
+    typename ContainerType::value_type, \
+    std::less<typename ContainerType::value_type>, \
+    typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type> \
   PIPE_OPERATOR(const ContainerType& value, const UnderscoreTags::TAG_NAME&) { \
-    return CONTAINER_NAME<typename ContainerType::value_type>(std::begin(value), std::end(value)); \
+    typedef typename ContainerType::value_type ValueType; \
+    typedef UnderscoreDetail::allocator_for<ContainerType, ValueType> AllocatorFor; \
+    return CONTAINER_NAME<ValueType, std::less<ValueType>, typename AllocatorFor::type>(std::begin(value), std::end(value), std::less<ValueType>(), AllocatorFor::get(value)); \
+  }
+#define CREATE_TO_SPECIFIC_UNORDERED_SET_PIPE(TAG_NAME, CONTAINER_NAME) \
+  CREATE_TAG_0_ARG( TAG_NAME ); \
+  template <typename ContainerType> \
+  CONTAINER_NAME< \
+    typename ContainerType::value_type, \
+    std::hash<typename ContainerType::value_type>, \
+    std::equal_to<typename ContainerType::value_type>, \
+    typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type> \
+  PIPE_OPERATOR(const ContainerType& value, const UnderscoreTags::TAG_NAME&) { \
+    typedef typename ContainerType::value_type ValueType; \
+    typedef UnderscoreDetail::allocator_for<ContainerType, ValueType> AllocatorFor; \
+    return CONTAINER_NAME<ValueType, std::hash<ValueType>, std::equal_to<ValueType>, typename AllocatorFor::type>( \
+      std::begin(value), std::end(value), 0, std::hash<ValueType>(), std::equal_to<ValueType>(), AllocatorFor::get(value)); \
   }
 
 /*
@@ -1205,10 +1663,116 @@ CREATE_TO_SPECIFIC_CONTAINER_PIPE( ToListTag, std::list );
 /// to_set, to_multiset, to_unordered_set
 CREATE_TO_SPECIFIC_SET_PIPE( ToSetTag, std::set );
 CREATE_TO_SPECIFIC_SET_PIPE( ToMultiSetTag, std::multiset );
-CREATE_TO_SPECIFIC_SET_PIPE( ToUnorderedSetTag, std::unordered_set );
+CREATE_TO_SPECIFIC_UNORDERED_SET_PIPE( ToUnorderedSetTag, std::unordered_set );
 //CREATE_TO_SPECIFIC_CONTAINER_TAG( ToMapTag, std::map ); // todo
 //CREATE_TO_SPECIFIC_CONTAINER_TAG( ToMultiMapTag, std::multi_map ); // todo
 
+/// with_allocator - copy into the same kind of container using the given allocator
+CREATE_TAG_1_ARG( WithAllocatorTag );
+template <typename ContainerType, typename AllocatorType>
+typename UnderscoreDetail::rebind_container<ContainerType, AllocatorType>::type
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::WithAllocatorTag1Arg<AllocatorType>& tag) {
+  typedef UnderscoreDetail::rebind_container<ContainerType, AllocatorType> Rebind;
+  return Rebind::make(std::begin(container), std::end(container), tag.arg0);
+}
+
+/// arena - bump allocate every container produced after piping through the arena
+namespace UnderscoreDetail {
+  template <typename T> struct arena_allocator;
+
+  // monotonic_arena, deallocation is a no-op and all memory is released at once when the arena dies
+  class monotonic_arena {
+  public:
+    explicit monotonic_arena(size_t initial_bytes)
+    : blocks_(nullptr)
+    , current_(nullptr)
+    , end_(nullptr)
+    , next_block_size_(initial_bytes < 64 ? 64 : initial_bytes)
+    , bytes_used_(0)
+    {}
+    monotonic_arena(monotonic_arena&& other)
+    : blocks_(other.blocks_)
+    , current_(other.current_)
+    , end_(other.end_)
+    , next_block_size_(other.next_block_size_)
+    , bytes_used_(other.bytes_used_) {
+      other.blocks_ = nullptr;
+      other.current_ = other.end_ = nullptr;
+      other.bytes_used_ = 0;
+    }
+    ~monotonic_arena() { release(); }
+    void* allocate(size_t num_bytes, size_t alignment) {
+      char* aligned = align(current_, alignment);
+      if (current_ == nullptr || aligned + num_bytes > end_) {
+        add_block(num_bytes + alignment);
+        aligned = align(current_, alignment);
+      }
+      current_ = aligned + num_bytes;
+      bytes_used_ += num_bytes;
+      return aligned;
+    }
+    void release() {
+      while (blocks_ != nullptr) {
+        block_header* next = blocks_->next;
+        ::operator delete(blocks_);
+        blocks_ = next;
+      }
+      current_ = end_ = nullptr;
+      bytes_used_ = 0;
+    }
+    size_t bytes_used() const { return bytes_used_; }
+    template <typename T>
+    arena_allocator<T> allocator() { return arena_allocator<T>(this); }
+  private:
+    monotonic_arena(const monotonic_arena&);
+    monotonic_arena& operator=(const monotonic_arena&);
+    struct block_header {
+      block_header* next;
+    };
+    static char* align(char* ptr, size_t alignment) {
+      const auto& address = reinterpret_cast<uintptr_t>(ptr);
+      return reinterpret_cast<char*>((address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    }
+    void add_block(size_t min_bytes) {
+      const size_t block_size = std::max(next_block_size_, min_bytes);
+      block_header* block = static_cast<block_header*>(::operator new(sizeof(block_header) + block_size));
+      block->next = blocks_;
+      blocks_ = block;
+      current_ = reinterpret_cast<char*>(block + 1);
+      end_ = current_ + block_size;
+      next_block_size_ = block_size * 2;
+    }
+    block_header* blocks_;
+    char* current_;
+    char* end_;
+    size_t next_block_size_;
+    size_t bytes_used_;
+  };
+
+  // arena_allocator
+  template <typename T>
+  struct arena_allocator {
+    typedef T value_type;
+    explicit arena_allocator(monotonic_arena* arena) : arena(arena) {}
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) : arena(other.arena) {}
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+    monotonic_arena* arena;
+  };
+  template <typename T, typename U>
+  bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) { return a.arena == b.arena; }
+  template <typename T, typename U>
+  bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) { return a.arena != b.arena; }
+}
+template <typename ContainerType>
+typename UnderscoreDetail::rebind_container<ContainerType, UnderscoreDetail::arena_allocator<typename ContainerType::value_type> >::type
+PIPE_OPERATOR(const ContainerType& container, UnderscoreDetail::monotonic_arena& arena) {
+  typedef UnderscoreDetail::arena_allocator<typename ContainerType::value_type> AllocatorType;
+  typedef UnderscoreDetail::rebind_container<ContainerType, AllocatorType> Rebind;
+  return Rebind::make(std::begin(container), std::end(container), arena.allocator<typename ContainerType::value_type>());
+}
+
 // CMath
 CREATE_PIPE_0_ARG(SinTag, ::sin);
 CREATE_PIPE_0_ARG(CosTag, ::cos);
@@ -1218,7 +1782,7 @@ CREATE_PIPE_0_ARG(AcosTag, ::acos);
 CREATE_PIPE_0_ARG(AtanTag, ::atan);
 CREATE_PIPE_0_ARG(SinhTag, ::sinh);
 CREATE_PIPE_0_ARG(CoshTag, ::cosh);
-CREATE_PIPE_0_ARG(AbsTag, ::abs);
+CREATE_PIPE_0_ARG(AbsTag, std::abs);
 CREATE_PIPE_0_ARG(FabsTag, ::fabs);
 CREATE_PIPE_0_ARG(ExpTag, ::exp);
 CREATE_PIPE_0_ARG(Exp2Tag, ::exp2);
@@ -1287,13 +1851,40 @@ PIPE_OPERATOR(ContainerType container, const UnderscoreTags::EraseAllUnstableTag
 }
 
 /// erase_all_if
+namespace UnderscoreDetail {
+  // remove_if_compact - in place left pack of trivially copyable elements, every element is written and the write
+  // position only advances past the kept ones, so there is no data dependent branch
+  template <typename ContainerType, typename PredicateType>
+  typename ContainerType::iterator
+  remove_if_compact(ContainerType& container, const PredicateType& predicate, std::true_type) {
+    typedef typename ContainerType::value_type ValueType;
+    const auto& first = std::begin(container);
+    const size_t size = static_cast<size_t>(std::distance(first, std::end(container)));
+    if (size == 0)
+      return first;
+    ValueType* values = std::addressof(*first);
+    size_t kept = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const ValueType value = values[i];
+      values[kept] = value;
+      kept += predicate(value) ? 0 : 1;
+    }
+    return std::next(first, static_cast<ptrdiff_t>(kept));
+  }
+  template <typename ContainerType, typename PredicateType>
+  typename ContainerType::iterator
+  remove_if_compact(ContainerType& container, const PredicateType& predicate, std::false_type) {
+    return std::remove_if(std::begin(container), std::end(container), predicate);
+  }
+}
 CREATE_TAG_1_ARG( EraseAllIfTag );
 template <typename ContainerType, typename ArgType0>
 ContainerType
 PIPE_OPERATOR(ContainerType container, const UnderscoreTags::EraseAllIfTag1Arg<ArgType0>& tag) {
-  const auto& end = std::end(container);
-  const auto& new_end = std::remove_if(std::begin(container), end, tag.arg0);
-  container.erase(new_end, end);
+  typedef std::integral_constant<bool,
+    UnderscoreDetail::is_contiguous_container<ContainerType>::value && std::is_trivially_copyable<typename ContainerType::value_type>::value> UseCompaction;
+  const auto& new_end = UnderscoreDetail::remove_if_compact(container, tag.arg0, UseCompaction());
+  container.erase(new_end, std::end(container));
   return container;
 }
 
@@ -1709,7 +2300,7 @@ CREATE_TAG_2_ARG_SAME_TYPE( ClampTag );
 template <typename ValueType>
 ValueType
 PIPE_OPERATOR(const ValueType& value, const UnderscoreTags::ClampTag2Arg<ValueType>& tag) {
-  if(value < tag.arg0) return tag.arg0;
+  if(!(value >= tag.arg0)) return tag.arg0; // NaN is not within [arg0, arg1] either, so it maps to the lower bound
   if(value > tag.arg1) return tag.arg1;
   return value;
 }
@@ -1950,36 +2541,6 @@ PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToContainerT
   return OutContainerType(std::begin(container), std::end(container));
 }
 
-/// copy_if
-CREATE_TAG_2_ARG( CopyIfTag );
-template <typename ContainerType, typename PredicateType, typename OutContainerType>
-typename std::decay<OutContainerType>::type
-PIPE_OPERATOR(const ContainerType& container, UnderscoreTags::CopyIfTag2Arg<PredicateType, OutContainerType>& tag) {
-  const auto& predicate = tag.arg0;
-  auto output_container = std::move(tag.arg1);
-  const auto& out_allocated_end = output_container.end();
-  const auto& input_end = container.end();
-  // Copy allocated part
-  auto input_iterator = container.begin();
-  auto output_iterator = output_container.begin();
-  for(; input_iterator != input_end && output_iterator != out_allocated_end; ++input_iterator) {
-    if (predicate(*input_iterator)) {
-      (*output_iterator) = (*input_iterator);
-      ++output_iterator;
-    }
-  }
-  // Push back the rest
-  while (input_iterator != input_end) {
-    if (predicate(*input_iterator)) {
-      output_container.push_back(*input_iterator);
-    }
-  }
-  // Erase slack if needed
-  if (output_iterator != output_container.end())
-    output_container.erase(output_iterator, output_container.end());
-  return output_container;
-}
-
 /// mutate
 CREATE_TAG_0_ARG( MutateTag );
 template <typename ContainerType>
@@ -2145,51 +2706,5296 @@ PIPE_OPERATOR(const ValueType*, const UnderscoreTags::TypeNameTag&) {
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-// Strings
+// Containers
 //
 
+/// optional
 namespace UnderscoreDetail {
-  template <typename StreamType, typename StringType>
-  struct make_string_base : public StringType {
-    typedef StringType inherited;
-    template <typename T>
-    make_string_base operator<<(const T& rhs) {
-      StreamType stream;
-      stream << rhs;
-      inherited::append(stream.str());
+#if __cplusplus >= 201703L
+  template <typename T>
+  using optional = std::optional<T>;
+#else
+  // optional - a value or nothing, stands in for std::optional before C++17
+  template <typename T>
+  class optional {
+  public:
+    optional() : has_value_(false), value_() {}
+    optional(const T& value) : has_value_(true), value_(value) {}
+    bool has_value() const { return has_value_; }
+    explicit operator bool() const { return has_value_; }
+    const T& value() const {
+      UNDERSCORE_ASSERT(has_value_);
+      return value_;
+    }
+    const T& operator*() const { return value_; }
+    const T* operator->() const { return &value_; }
+    T value_or(const T& fallback) const { return has_value_ ? value_ : fallback; }
+    bool operator==(const optional& other) const { return has_value_ == other.has_value_ && (!has_value_ || value_ == other.value_); }
+    bool operator!=(const optional& other) const { return !(*this == other); }
+  private:
+    bool has_value_;
+    T value_;
+  };
+#endif
+}
+
+/// small_vector
+namespace UnderscoreDetail {
+  // small_vector - vector storing up to N elements inline before touching the heap
+  template <typename T, size_t N>
+  class small_vector {
+    UNDERSCORE_STATIC_ASSERT(N > 0, "Underscore Library Error: small_vector requires an inline capacity above zero.");
+  public:
+    typedef T value_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    small_vector() : data_(inline_data()), size_(0), capacity_(N) {}
+    explicit small_vector(size_type n) : data_(inline_data()), size_(0), capacity_(N) { resize(n); }
+    small_vector(size_type n, const T& value) : data_(inline_data()), size_(0), capacity_(N) { assign(n, value); }
+    template <typename InputIterator, typename = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    small_vector(InputIterator first, InputIterator last) : data_(inline_data()), size_(0), capacity_(N) { assign(first, last); }
+    small_vector(std::initializer_list<T> values) : data_(inline_data()), size_(0), capacity_(N) { assign(values.begin(), values.end()); }
+    small_vector(const small_vector& other) : data_(inline_data()), size_(0), capacity_(N) { assign(other.begin(), other.end()); }
+    small_vector(small_vector&& other) : data_(inline_data()), size_(0), capacity_(N) { steal(other); }
+    ~small_vector() {
+      clear();
+      release();
+    }
+    small_vector& operator=(const small_vector& other) {
+      if (this != &other)
+        assign(other.begin(), other.end());
       return *this;
     }
-    template <typename T>
-    make_string_base operator<<(const std::basic_string<T>& rhs) {
-      StringType str(rhs.begin(), rhs.end());
-      inherited::append(str);
+    small_vector& operator=(small_vector&& other) {
+      if (this != &other) {
+        clear();
+        release();
+        steal(other);
+      }
       return *this;
     }
-  };
-  typedef make_string_base<std::stringstream, std::string> make_string;
-  typedef make_string_base<std::wstringstream, std::wstring> make_wstring;
-
-  // container_to_string
-  template <typename StringType, typename StreamType, typename ContainerType>
-  StringType
-  container_to_string(const ContainerType& container) {
-    auto first = std::begin(container);
-    const auto& last = std::end(container);
-    const auto& prev_last = std::prev(last);
-    StreamType sstr;
-    sstr << "[";
-    while(first != last) {
-      sstr << (*first);
-      if (first != prev_last)
-        sstr << ", ";
-      ++first;
+    // Capacity
+    size_type size() const { return size_; }
+    size_type capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    bool is_inline() const { return data_ == inline_data(); }
+    void reserve(size_type n) {
+      if (n <= capacity_)
+        return;
+      T* new_data = std::allocator<T>().allocate(n);
+      for (size_type i = 0; i < size_; ++i) {
+        ::new (static_cast<void*>(new_data + i)) T(std::move(data_[i]));
+        data_[i].~T();
+      }
+      release();
+      data_ = new_data;
+      capacity_ = n;
     }
-    sstr << "]";
-    return sstr.str();
+    void shrink_to_fit() {
+      if (is_inline() || size_ > N)
+        return;
+      T* heap_data = data_;
+      const size_type heap_capacity = capacity_;
+      data_ = inline_data();
+      for (size_type i = 0; i < size_; ++i) {
+        ::new (static_cast<void*>(data_ + i)) T(std::move(heap_data[i]));
+        heap_data[i].~T();
+      }
+      std::allocator<T>().deallocate(heap_data, heap_capacity);
+      capacity_ = N;
+    }
+    // Mutating functions
+    template <typename InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+      clear();
+      for (; first != last; ++first)
+        emplace_back(*first);
+    }
+    void assign(size_type n, const T& value) {
+      clear();
+      reserve(n);
+      for (size_type i = 0; i < n; ++i)
+        emplace_back(value);
+    }
+    void clear() {
+      for (size_type i = 0; i < size_; ++i)
+        data_[i].~T();
+      size_ = 0;
+    }
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+    template <typename... ArgTypes>
+    reference emplace_back(ArgTypes&&... args) {
+      if (size_ == capacity_) {
+        T value(std::forward<ArgTypes>(args)...); // args may refer to an element of this vector
+        reserve(capacity_ * 2);
+        ::new (static_cast<void*>(data_ + size_)) T(std::move(value));
+      } else {
+        ::new (static_cast<void*>(data_ + size_)) T(std::forward<ArgTypes>(args)...);
+      }
+      return data_[size_++];
+    }
+    void pop_back() {
+      UNDERSCORE_ASSERT(size_ > 0);
+      data_[--size_].~T();
+    }
+    iterator insert(const_iterator position, const T& value) {
+      const size_type idx = position - begin();
+      push_back(value);
+      std::rotate(begin() + idx, end() - 1, end());
+      return begin() + idx;
+    }
+    iterator insert(const_iterator position, size_type n, const T& value) {
+      const size_type idx = position - begin();
+      const size_type old_size = size_;
+      const T copy = value;
+      reserve(size_ + n);
+      for (size_type i = 0; i < n; ++i)
+        emplace_back(copy);
+      std::rotate(begin() + idx, begin() + old_size, end());
+      return begin() + idx;
+    }
+    template <typename InputIterator, typename = typename std::enable_if<!std::is_integral<InputIterator>::value>::type>
+    iterator insert(const_iterator position, InputIterator first, InputIterator last) {
+      const size_type idx = position - begin();
+      const size_type old_size = size_;
+      for (; first != last; ++first)
+        emplace_back(*first);
+      std::rotate(begin() + idx, begin() + old_size, end());
+      return begin() + idx;
+    }
+    iterator erase(const_iterator position) { return erase(position, position + 1); }
+    iterator erase(const_iterator first, const_iterator last) {
+      iterator left = begin() + (first - begin());
+      iterator right = begin() + (last - begin());
+      iterator new_end = std::move(right, end(), left);
+      for (iterator it = new_end; it != end(); ++it)
+        it->~T();
+      size_ -= static_cast<size_type>(right - left);
+      return left;
+    }
+    void resize(size_type n) {
+      while (size_ > n)
+        pop_back();
+      reserve(n);
+      while (size_ < n)
+        emplace_back();
+    }
+    void resize(size_type n, const T& value) {
+      while (size_ > n)
+        pop_back();
+      reserve(n);
+      while (size_ < n)
+        emplace_back(value);
+    }
+    void swap(small_vector& other) {
+      small_vector tmp(std::move(other));
+      other = std::move(*this);
+      *this = std::move(tmp);
+    }
+    // Element access
+    reference front() { return data_[0]; }
+    const_reference front() const { return data_[0]; }
+    reference back() { return data_[size_ - 1]; }
+    const_reference back() const { return data_[size_ - 1]; }
+    reference at(size_type idx) { UNDERSCORE_ASSERT(idx < size_); return data_[idx]; }
+    const_reference at(size_type idx) const { UNDERSCORE_ASSERT(idx < size_); return data_[idx]; }
+    reference operator[](size_type idx) { return data_[idx]; }
+    const_reference operator[](size_type idx) const { return data_[idx]; }
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    // Iterator access
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator crend() const { return const_reverse_iterator(begin()); }
+  private:
+    T* inline_data() { return reinterpret_cast<T*>(&inline_storage_); }
+    const T* inline_data() const { return reinterpret_cast<const T*>(&inline_storage_); }
+    void release() {
+      if (!is_inline())
+        std::allocator<T>().deallocate(data_, capacity_);
+      data_ = inline_data();
+      capacity_ = N;
+    }
+    void steal(small_vector& other) {
+      if (other.is_inline()) {
+        for (size_type i = 0; i < other.size_; ++i)
+          ::new (static_cast<void*>(data_ + i)) T(std::move(other.data_[i]));
+        size_ = other.size_;
+        other.clear();
+      } else {
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        other.data_ = other.inline_data();
+        other.size_ = 0;
+        other.capacity_ = N;
+      }
+    }
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type inline_storage_;
+    T* data_;
+    size_type size_;
+    size_type capacity_;
+  };
+  template <typename T, size_t N>
+  struct is_contiguous_container<small_vector<T, N> > : std::true_type {};
+  template <typename T, size_t N>
+  bool operator==(const small_vector<T, N>& a, const small_vector<T, N>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
   }
-  template <typename ValueType> // is arithmetic, not a container - use std::to_string
-  std::string to_string_impl(const ValueType& value, std::true_type, std::false_type) {
-    return std::to_string(value);
+  template <typename T, size_t N>
+  bool operator!=(const small_vector<T, N>& a, const small_vector<T, N>& b) { return !(a == b); }
+  template <typename T, size_t N>
+  bool operator<(const small_vector<T, N>& a, const small_vector<T, N>& b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+  }
+}
+namespace UnderscoreTags { template <size_t N> struct ToSmallVectorTag {}; }
+template <typename ContainerType, size_t N>
+UnderscoreDetail::small_vector<typename ContainerType::value_type, N>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToSmallVectorTag<N>&) {
+  return UnderscoreDetail::small_vector<typename ContainerType::value_type, N>(std::begin(container), std::end(container));
+}
+
+
+
+/// flat_set, flat_map
+namespace UnderscoreDetail {
+
+  // key_compare_adaptor - compares the keys of flat_map elements
+  template <typename KeyType, typename ValueType, typename CompareType>
+  struct key_compare_adaptor {
+    typedef std::pair<KeyType, ValueType> pair_type;
+    key_compare_adaptor(const CompareType& compare) : compare(compare) {}
+    bool operator()(const pair_type& a, const pair_type& b) const { return compare(a.first, b.first); }
+    bool operator()(const pair_type& a, const KeyType& b) const { return compare(a.first, b); }
+    bool operator()(const KeyType& a, const pair_type& b) const { return compare(a, b.first); }
+    CompareType compare;
+  };
+
+  // sorted_unique_t - marks input which is already sorted and free of duplicates
+  struct sorted_unique_t {};
+
+  // flat_set - sorted unique elements in contiguous memory
+  template <typename T, typename CompareType = std::less<T>, typename AllocType = std::allocator<T> >
+  class flat_set {
+    typedef std::vector<T, AllocType> storage_type;
+  public:
+    typedef storage_type container_type;
+    typedef T key_type;
+    typedef T value_type;
+    typedef CompareType key_compare;
+    typedef CompareType value_compare;
+    typedef AllocType allocator_type;
+    typedef const T& reference;
+    typedef const T& const_reference;
+    typedef typename storage_type::size_type size_type;
+    typedef typename storage_type::difference_type difference_type;
+    typedef typename storage_type::const_iterator iterator;
+    typedef typename storage_type::const_iterator const_iterator;
+    typedef typename storage_type::const_reverse_iterator reverse_iterator;
+    typedef typename storage_type::const_reverse_iterator const_reverse_iterator;
+
+    flat_set() {}
+    explicit flat_set(const CompareType& compare, const AllocType& allocator = AllocType())
+    : elements_(allocator)
+    , compare_(compare)
+    {}
+    explicit flat_set(const AllocType& allocator)
+    : elements_(allocator)
+    {}
+    template <typename InputIterator>
+    flat_set(InputIterator first, InputIterator last, const CompareType& compare = CompareType(), const AllocType& allocator = AllocType())
+    : elements_(first, last, allocator)
+    , compare_(compare) {
+      sort_and_unique();
+    }
+    flat_set(std::initializer_list<T> values)
+    : elements_(values) {
+      sort_and_unique();
+    }
+    flat_set(sorted_unique_t, container_type&& elements, const CompareType& compare = CompareType())
+    : elements_(std::move(elements))
+    , compare_(compare)
+    {}
+    // Lookup
+    const_iterator find(const T& value) const {
+      const auto& pos = lower_bound(value);
+      return (pos != end() && !compare_(value, *pos)) ? pos : end();
+    }
+    bool contains(const T& value) const { return find(value) != end(); }
+    size_type count(const T& value) const { return contains(value) ? 1 : 0; }
+    const_iterator lower_bound(const T& value) const { return branchless_lower_bound(begin(), end(), value, compare_); }
+    const_iterator upper_bound(const T& value) const { return branchless_upper_bound(begin(), end(), value, compare_); }
+    std::pair<const_iterator, const_iterator> equal_range(const T& value) const {
+      const auto& first = lower_bound(value);
+      const auto& last = (first != end() && !compare_(value, *first)) ? std::next(first) : first;
+      return std::make_pair(first, last);
+    }
+    // Modifiers
+    std::pair<iterator, bool> insert(const T& value) {
+      const auto& pos = lower_bound(value);
+      if (pos != end() && !compare_(value, *pos))
+        return std::make_pair(pos, false);
+      return std::make_pair(elements_.insert(pos, value), true);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+      const auto& old_size = elements_.size();
+      elements_.insert(elements_.end(), first, last);
+      std::sort(elements_.begin() + old_size, elements_.end(), compare_);
+      std::inplace_merge(elements_.begin(), elements_.begin() + old_size, elements_.end(), compare_);
+      erase_duplicates();
+    }
+    size_type erase(const T& value) {
+      const auto& pos = find(value);
+      if (pos == end())
+        return 0;
+      elements_.erase(pos);
+      return 1;
+    }
+    iterator erase(const_iterator pos) { return elements_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return elements_.erase(first, last); }
+    void clear() { elements_.clear(); }
+    void reserve(size_type n) { elements_.reserve(n); }
+    void shrink_to_fit() { elements_.shrink_to_fit(); }
+    void swap(flat_set& other) {
+      elements_.swap(other.elements_);
+      std::swap(compare_, other.compare_);
+    }
+    // Capacity and access
+    size_type size() const { return elements_.size(); }
+    bool empty() const { return elements_.empty(); }
+    const T* data() const { return elements_.data(); }
+    const container_type& elements() const { return elements_; }
+    const_reference operator[](size_type idx) const { return elements_[idx]; }
+    const_reference front() const { return elements_.front(); }
+    const_reference back() const { return elements_.back(); }
+    key_compare key_comp() const { return compare_; }
+    allocator_type get_allocator() const { return elements_.get_allocator(); }
+    const_iterator begin() const { return elements_.begin(); }
+    const_iterator end() const { return elements_.end(); }
+    const_iterator cbegin() const { return elements_.begin(); }
+    const_iterator cend() const { return elements_.end(); }
+    const_reverse_iterator rbegin() const { return elements_.rbegin(); }
+    const_reverse_iterator rend() const { return elements_.rend(); }
+    const_reverse_iterator crbegin() const { return elements_.rbegin(); }
+    const_reverse_iterator crend() const { return elements_.rend(); }
+    bool operator==(const flat_set& other) const { return elements_ == other.elements_; }
+    bool operator!=(const flat_set& other) const { return elements_ != other.elements_; }
+    bool operator<(const flat_set& other) const { return elements_ < other.elements_; }
+  private:
+    void sort_and_unique() {
+      std::sort(elements_.begin(), elements_.end(), compare_);
+      erase_duplicates();
+    }
+    void erase_duplicates() {
+      const CompareType& compare = compare_;
+      elements_.erase(std::unique(elements_.begin(), elements_.end(), [&compare](const T& a, const T& b) { return !compare(a, b); }), elements_.end());
+    }
+    storage_type elements_;
+    CompareType compare_;
+  };
+
+  // flat_map - sorted unique key-value pairs in contiguous memory
+  template <typename KeyType, typename ValueType, typename CompareType = std::less<KeyType>, typename AllocType = std::allocator<std::pair<KeyType, ValueType> > >
+  class flat_map {
+    typedef std::vector<std::pair<KeyType, ValueType>, AllocType> storage_type;
+    typedef key_compare_adaptor<KeyType, ValueType, CompareType> pair_compare_type;
+  public:
+    typedef storage_type container_type;
+    typedef KeyType key_type;
+    typedef ValueType mapped_type;
+    typedef std::pair<KeyType, ValueType> value_type;
+    typedef CompareType key_compare;
+    typedef AllocType allocator_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef typename storage_type::size_type size_type;
+    typedef typename storage_type::difference_type difference_type;
+    typedef typename storage_type::iterator iterator;
+    typedef typename storage_type::const_iterator const_iterator;
+    typedef typename storage_type::reverse_iterator reverse_iterator;
+    typedef typename storage_type::const_reverse_iterator const_reverse_iterator;
+
+    flat_map() : compare_(CompareType()) {}
+    explicit flat_map(const CompareType& compare, const AllocType& allocator = AllocType())
+    : elements_(allocator)
+    , compare_(compare)
+    {}
+    explicit flat_map(const AllocType& allocator)
+    : elements_(allocator)
+    , compare_(CompareType())
+    {}
+    template <typename InputIterator>
+    flat_map(InputIterator first, InputIterator last, const CompareType& compare = CompareType(), const AllocType& allocator = AllocType())
+    : elements_(first, last, allocator)
+    , compare_(compare) {
+      sort_and_unique();
+    }
+    flat_map(std::initializer_list<value_type> values)
+    : elements_(values)
+    , compare_(CompareType()) {
+      sort_and_unique();
+    }
+    flat_map(sorted_unique_t, container_type&& elements, const CompareType& compare = CompareType())
+    : elements_(std::move(elements))
+    , compare_(compare)
+    {}
+    // Lookup
+    iterator find(const KeyType& key) {
+      const auto& pos = lower_bound(key);
+      return (pos != end() && !compare_.compare(key, pos->first)) ? pos : end();
+    }
+    const_iterator find(const KeyType& key) const {
+      const auto& pos = lower_bound(key);
+      return (pos != end() && !compare_.compare(key, pos->first)) ? pos : end();
+    }
+    bool contains(const KeyType& key) const { return find(key) != end(); }
+    size_type count(const KeyType& key) const { return contains(key) ? 1 : 0; }
+    iterator lower_bound(const KeyType& key) { return branchless_lower_bound(begin(), end(), key, compare_); }
+    const_iterator lower_bound(const KeyType& key) const { return branchless_lower_bound(begin(), end(), key, compare_); }
+    iterator upper_bound(const KeyType& key) { return branchless_upper_bound(begin(), end(), key, compare_); }
+    const_iterator upper_bound(const KeyType& key) const { return branchless_upper_bound(begin(), end(), key, compare_); }
+    ValueType& at(const KeyType& key) {
+      const auto& pos = find(key);
+      UNDERSCORE_ASSERT(pos != end());
+      return pos->second;
+    }
+    const ValueType& at(const KeyType& key) const {
+      const auto& pos = find(key);
+      UNDERSCORE_ASSERT(pos != end());
+      return pos->second;
+    }
+    ValueType& operator[](const KeyType& key) {
+      auto pos = lower_bound(key);
+      if (pos == end() || compare_.compare(key, pos->first))
+        pos = elements_.insert(pos, value_type(key, ValueType()));
+      return pos->second;
+    }
+    // Modifiers
+    std::pair<iterator, bool> insert(const value_type& value) {
+      const auto& pos = lower_bound(value.first);
+      if (pos != end() && !compare_.compare(value.first, pos->first))
+        return std::make_pair(pos, false);
+      return std::make_pair(elements_.insert(pos, value), true);
+    }
+    size_type erase(const KeyType& key) {
+      const auto& pos = find(key);
+      if (pos == end())
+        return 0;
+      elements_.erase(pos);
+      return 1;
+    }
+    iterator erase(const_iterator pos) { return elements_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return elements_.erase(first, last); }
+    void clear() { elements_.clear(); }
+    void reserve(size_type n) { elements_.reserve(n); }
+    void shrink_to_fit() { elements_.shrink_to_fit(); }
+    // Capacity and access
+    size_type size() const { return elements_.size(); }
+    bool empty() const { return elements_.empty(); }
+    const value_type* data() const { return elements_.data(); }
+    key_compare key_comp() const { return compare_.compare; }
+    allocator_type get_allocator() const { return elements_.get_allocator(); }
+    iterator begin() { return elements_.begin(); }
+    iterator end() { return elements_.end(); }
+    const_iterator begin() const { return elements_.begin(); }
+    const_iterator end() const { return elements_.end(); }
+    const_iterator cbegin() const { return elements_.begin(); }
+    const_iterator cend() const { return elements_.end(); }
+    reverse_iterator rbegin() { return elements_.rbegin(); }
+    reverse_iterator rend() { return elements_.rend(); }
+    const_reverse_iterator rbegin() const { return elements_.rbegin(); }
+    const_reverse_iterator rend() const { return elements_.rend(); }
+    bool operator==(const flat_map& other) const { return elements_ == other.elements_; }
+    bool operator!=(const flat_map& other) const { return elements_ != other.elements_; }
+  private:
+    void sort_and_unique() { // keeps the first occurrence of each key
+      std::stable_sort(elements_.begin(), elements_.end(), compare_);
+      const pair_compare_type& compare = compare_;
+      elements_.erase(std::unique(elements_.begin(), elements_.end(), [&compare](const value_type& a, const value_type& b) { return !compare(a, b); }), elements_.end());
+    }
+    storage_type elements_;
+    pair_compare_type compare_;
+  };
+}
+CREATE_TAG_0_ARG( ToFlatSetTag );
+template <typename ContainerType>
+UnderscoreDetail::flat_set<
+  typename ContainerType::value_type,
+  std::less<typename ContainerType::value_type>,
+  typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToFlatSetTag&) {
+  typedef typename ContainerType::value_type ValueType;
+  typedef UnderscoreDetail::allocator_for<ContainerType, ValueType> AllocatorFor;
+  return UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, typename AllocatorFor::type>(
+    std::begin(container), std::end(container), std::less<ValueType>(), AllocatorFor::get(container));
+}
+namespace UnderscoreTags {
+  IMPLEMENTS_2_ARG_TAG( ToFlatMapTag )
+  struct ToFlatMapTag {
+    ToFlatMapTag() {}
+    ToFlatMapTag& operator=(const ToFlatMapTag&);
+    IMPLEMENTS_2_ARG_OPERATOR( ToFlatMapTag )
+  };
+}
+template <typename ContainerType> // container of pairs
+UnderscoreDetail::flat_map<
+  typename std::remove_const<typename ContainerType::value_type::first_type>::type,
+  typename ContainerType::value_type::second_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToFlatMapTag&) {
+  typedef typename std::remove_const<typename ContainerType::value_type::first_type>::type KeyType;
+  typedef typename ContainerType::value_type::second_type ValueType;
+  return UnderscoreDetail::flat_map<KeyType, ValueType>(std::begin(container), std::end(container));
+}
+template <typename ContainerType, typename KeyFunctorType, typename ValueFunctorType> // key and value functors
+UnderscoreDetail::flat_map<
+  typename std::decay<typename std::result_of<KeyFunctorType(typename ContainerType::value_type)>::type>::type,
+  typename std::decay<typename std::result_of<ValueFunctorType(typename ContainerType::value_type)>::type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToFlatMapTag2Arg<KeyFunctorType, ValueFunctorType>& tag) {
+  typedef typename std::decay<typename std::result_of<KeyFunctorType(typename ContainerType::value_type)>::type>::type KeyType;
+  typedef typename std::decay<typename std::result_of<ValueFunctorType(typename ContainerType::value_type)>::type>::type ValueType;
+  std::vector<std::pair<KeyType, ValueType> > pairs;
+  pairs.reserve(container.size());
+  for (auto it = std::begin(container); it != std::end(container); ++it)
+    pairs.emplace_back(tag.arg0(*it), tag.arg1(*it));
+  return UnderscoreDetail::flat_map<KeyType, ValueType>(std::make_move_iterator(pairs.begin()), std::make_move_iterator(pairs.end()));
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // flat_set find
+typename UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0>
+typename UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>::const_iterator
+PIPE_OPERATOR(UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename KeyType, typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // immutable flat_map find
+typename UnderscoreDetail::flat_map<KeyType, ValueType, CompareType, AllocType>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::flat_map<KeyType, ValueType, CompareType, AllocType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename KeyType, typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // mutable flat_map find
+typename UnderscoreDetail::flat_map<KeyType, ValueType, CompareType, AllocType>::iterator
+PIPE_OPERATOR(UnderscoreDetail::flat_map<KeyType, ValueType, CompareType, AllocType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // flat_set contains
+bool
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::AnyOfEqualTag1Arg<ArgType0>& tag) {
+  return container.contains(tag.arg0);
+}
+template <typename KeyType, typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // flat_map contains key
+bool
+PIPE_OPERATOR(const UnderscoreDetail::flat_map<KeyType, ValueType, CompareType, AllocType>& container, const UnderscoreTags::AnyOfEqualTag1Arg<ArgType0>& tag) {
+  return container.contains(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // flat_set binary_search
+bool
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::BinarySearchTag1Arg<ArgType0>& tag) {
+  return container.contains(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // flat_set lower_bound
+typename UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::LowerBoundTag1Arg<ArgType0>& tag) {
+  return container.lower_bound(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0>
+typename UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>::const_iterator
+PIPE_OPERATOR(UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::LowerBoundTag1Arg<ArgType0>& tag) {
+  return container.lower_bound(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0> // flat_set upper_bound
+typename UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::UpperBoundTag1Arg<ArgType0>& tag) {
+  return container.upper_bound(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename ArgType0>
+typename UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>::const_iterator
+PIPE_OPERATOR(UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::UpperBoundTag1Arg<ArgType0>& tag) {
+  return container.upper_bound(tag.arg0);
+}
+template <typename ValueType, typename CompareType, typename AllocType, typename OtherContainerType> // flat_set includes, the other container may be unsorted
+bool
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::IncludesTag1Arg<OtherContainerType>& tag) {
+  for (auto it = std::begin(tag.arg0); it != std::end(tag.arg0); ++it)
+    if (!container.contains(*it))
+      return false;
+  return true;
+}
+template <typename ValueType, typename CompareType, typename AllocType> // both sorted, linear merge when sizes are alike
+bool
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::IncludesTag1Arg<UnderscoreDetail::flat_set<ValueType, CompareType, AllocType> >& tag) {
+  if (tag.arg0.size() > container.size())
+    return false;
+  if (tag.arg0.size() * 8 < container.size())
+    return std::all_of(tag.arg0.begin(), tag.arg0.end(), [&container](const ValueType& value) { return container.contains(value); });
+  return std::includes(container.begin(), container.end(), tag.arg0.begin(), tag.arg0.end(), container.key_comp());
+}
+
+
+
+/// hash_set, hash_map
+namespace UnderscoreDetail {
+  // count_trailing_zeros - index of the lowest set bit, mask must not be zero
+  inline unsigned count_trailing_zeros(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned idx = 0;
+    while ((mask & 1) == 0) {
+      mask >>= 1;
+      ++idx;
+    }
+    return idx;
+#endif
+  }
+  inline unsigned count_trailing_zeros(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+    unsigned idx = 0;
+    while ((mask & 1) == 0) {
+      mask >>= 1;
+      ++idx;
+    }
+    return idx;
+#endif
+  }
+  inline size_t count_set_bits(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<size_t>(__builtin_popcountll(mask));
+#else
+    mask = mask - ((mask >> 1) & 0x5555555555555555ull);
+    mask = (mask & 0x3333333333333333ull) + ((mask >> 2) & 0x3333333333333333ull);
+    mask = (mask + (mask >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<size_t>((mask * 0x0101010101010101ull) >> 56);
+#endif
+  }
+
+  struct identity_key {
+    template <typename T>
+    const T& operator()(const T& value) const { return value; }
+  };
+  struct pair_first_key {
+    template <typename PairType>
+    const typename PairType::first_type& operator()(const PairType& value) const { return value.first; }
+  };
+
+  // swiss_table - open addressing with one control byte per slot, probed a group of 16 slots at a time.
+  // A control byte is either empty, deleted or the low 7 bits of the hash of the stored element.
+  template <typename KeyType, typename ValueType, typename KeyOfValueType, typename HashType, typename EqualType>
+  class swiss_table {
+  protected:
+    enum control_byte : int8_t { ctrl_empty = -128, ctrl_deleted = -2 };
+    const static size_t group_width = 16;
+    const static size_t npos = static_cast<size_t>(-1);
+  public:
+    typedef KeyType key_type;
+    typedef ValueType value_type;
+    typedef HashType hasher;
+    typedef EqualType key_equal;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename ReferenceType, typename PointerType>
+    class basic_iterator {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef typename swiss_table::value_type value_type;
+      typedef ptrdiff_t difference_type;
+      typedef PointerType pointer;
+      typedef ReferenceType reference;
+      basic_iterator() : ctrl_(nullptr), ctrl_end_(nullptr), slot_(nullptr) {}
+      basic_iterator(const int8_t* ctrl, const int8_t* ctrl_end, ValueType* slot)
+      : ctrl_(ctrl)
+      , ctrl_end_(ctrl_end)
+      , slot_(slot) {
+        skip_unused();
+      }
+      template <typename OtherReferenceType, typename OtherPointerType>
+      basic_iterator(const basic_iterator<OtherReferenceType, OtherPointerType>& other)
+      : ctrl_(other.ctrl_)
+      , ctrl_end_(other.ctrl_end_)
+      , slot_(other.slot_)
+      {}
+      reference operator*() const { return *slot_; }
+      pointer operator->() const { return slot_; }
+      basic_iterator& operator++() {
+        ++ctrl_;
+        ++slot_;
+        skip_unused();
+        return *this;
+      }
+      basic_iterator operator++(int) {
+        basic_iterator copy = *this;
+        ++*this;
+        return copy;
+      }
+      bool operator==(const basic_iterator& other) const { return slot_ == other.slot_; }
+      bool operator!=(const basic_iterator& other) const { return slot_ != other.slot_; }
+    private:
+      template <typename, typename> friend class basic_iterator;
+      void skip_unused() {
+        while (ctrl_ != ctrl_end_ && *ctrl_ < 0) {
+          ++ctrl_;
+          ++slot_;
+        }
+      }
+      const int8_t* ctrl_;
+      const int8_t* ctrl_end_;
+      ValueType* slot_;
+    };
+    typedef basic_iterator<ValueType&, ValueType*> iterator;
+    typedef basic_iterator<const ValueType&, const ValueType*> const_iterator;
+
+    swiss_table()
+    : ctrl_(nullptr)
+    , slots_(nullptr)
+    , capacity_(0)
+    , size_(0)
+    , deleted_(0)
+    {}
+    swiss_table(const swiss_table& other)
+    : ctrl_(nullptr)
+    , slots_(nullptr)
+    , capacity_(0)
+    , size_(0)
+    , deleted_(0)
+    , hasher_(other.hasher_)
+    , equal_(other.equal_) {
+      reserve(other.size());
+      for (auto it = other.begin(); it != other.end(); ++it)
+        emplace_key(KeyOfValueType()(*it), *it);
+    }
+    swiss_table(swiss_table&& other)
+    : ctrl_(nullptr)
+    , slots_(nullptr)
+    , capacity_(0)
+    , size_(0)
+    , deleted_(0) {
+      swap(other);
+    }
+    swiss_table& operator=(swiss_table other) {
+      swap(other);
+      return *this;
+    }
+    ~swiss_table() {
+      destroy_elements();
+      deallocate();
+    }
+    void swap(swiss_table& other) {
+      std::swap(ctrl_, other.ctrl_);
+      std::swap(slots_, other.slots_);
+      std::swap(capacity_, other.capacity_);
+      std::swap(size_, other.size_);
+      std::swap(deleted_, other.deleted_);
+      std::swap(hasher_, other.hasher_);
+      std::swap(equal_, other.equal_);
+    }
+    // Lookup
+    iterator find(const KeyType& key) { return iterator_at(find_index(key, hasher_(key))); }
+    const_iterator find(const KeyType& key) const { return iterator_at(find_index(key, hasher_(key))); }
+    bool contains(const KeyType& key) const { return find_index(key, hasher_(key)) != npos; }
+    size_type count(const KeyType& key) const { return contains(key) ? 1 : 0; }
+    // Modifiers
+    size_type erase(const KeyType& key) {
+      const size_t idx = find_index(key, hasher_(key));
+      if (idx == npos)
+        return 0;
+      slots_[idx].~ValueType();
+      set_ctrl(idx, ctrl_deleted);
+      --size_;
+      ++deleted_;
+      return 1;
+    }
+    void clear() {
+      destroy_elements();
+      if (capacity_ != 0)
+        std::fill(ctrl_, ctrl_ + capacity_ + group_width, ctrl_empty);
+      size_ = 0;
+      deleted_ = 0;
+    }
+    // reserve - makes room for n elements without further rehashing
+    void reserve(size_type n) {
+      const size_t capacity = capacity_for(n);
+      if (capacity > capacity_)
+        rehash(capacity);
+    }
+    // Capacity
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_type bucket_count() const { return capacity_; }
+    float load_factor() const { return capacity_ == 0 ? 0.0f : static_cast<float>(size_) / static_cast<float>(capacity_); }
+    hasher hash_function() const { return hasher_; }
+    key_equal key_eq() const { return equal_; }
+    iterator begin() { return iterator(ctrl_, ctrl_ + capacity_, slots_); }
+    iterator end() { return iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_); }
+    const_iterator begin() const { return const_iterator(ctrl_, ctrl_ + capacity_, slots_); }
+    const_iterator end() const { return const_iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+  protected:
+    // reserve_range - reserves for the elements of a multi-pass range, a single-pass range can only be counted by consuming it
+    template <typename IteratorType>
+    void reserve_range(IteratorType first, IteratorType last, std::forward_iterator_tag) {
+      reserve(size_ + static_cast<size_t>(std::distance(first, last)));
+    }
+    template <typename IteratorType>
+    void reserve_range(IteratorType, IteratorType, std::input_iterator_tag) {}
+    template <typename IteratorType>
+    void reserve_range(IteratorType first, IteratorType last) {
+      reserve_range(first, last, typename std::iterator_traits<IteratorType>::iterator_category());
+    }
+    // match - bitmask of the group slots whose control byte equals value
+    static uint32_t match(const int8_t* group, int8_t value) {
+#if UNDERSCORE_SSE2
+      const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+      return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+      uint32_t mask = 0;
+      for (size_t i = 0; i < group_width; ++i)
+        mask |= static_cast<uint32_t>(group[i] == value) << i;
+      return mask;
+#endif
+    }
+    // match_unused - bitmask of the group slots which are empty or deleted, ie has the high bit set
+    static uint32_t match_unused(const int8_t* group) {
+#if UNDERSCORE_SSE2
+      return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+#else
+      uint32_t mask = 0;
+      for (size_t i = 0; i < group_width; ++i)
+        mask |= static_cast<uint32_t>(group[i] < 0) << i;
+      return mask;
+#endif
+    }
+    static int8_t hash_tag(size_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+    static size_t capacity_for(size_t n) { // max load factor is 7/8
+      size_t capacity = group_width;
+      while (capacity - capacity / 8 < n)
+        capacity *= 2;
+      return capacity;
+    }
+    size_t find_index(const KeyType& key, size_t hash) const {
+      if (capacity_ == 0)
+        return npos;
+      const size_t mask = capacity_ - 1;
+      const int8_t tag = hash_tag(hash);
+      size_t pos = (hash >> 7) & mask;
+      for (size_t step = group_width; ; step += group_width) {
+        const int8_t* group = ctrl_ + pos;
+        for (uint32_t m = match(group, tag); m != 0; m &= m - 1) {
+          const size_t idx = (pos + count_trailing_zeros(m)) & mask;
+          if (equal_(KeyOfValueType()(slots_[idx]), key))
+            return idx;
+        }
+        if (match(group, ctrl_empty) != 0)
+          return npos;
+        pos = (pos + step) & mask; // triangular probing visits every group
+      }
+    }
+    size_t find_unused(size_t hash) const {
+      const size_t mask = capacity_ - 1;
+      size_t pos = (hash >> 7) & mask;
+      for (size_t step = group_width; ; step += group_width) {
+        const uint32_t m = match_unused(ctrl_ + pos);
+        if (m != 0)
+          return (pos + count_trailing_zeros(m)) & mask;
+        pos = (pos + step) & mask;
+      }
+    }
+    template <typename... ArgTypes>
+    std::pair<size_t, bool> emplace_key(const KeyType& key, ArgTypes&&... args) {
+      const size_t hash = hasher_(key);
+      const size_t found = find_index(key, hash);
+      if (found != npos)
+        return std::make_pair(found, false);
+      if (capacity_ == 0 || size_ + deleted_ + 1 > capacity_ - capacity_ / 8)
+        rehash(capacity_for((size_ + 1) * 2));
+      const size_t idx = find_unused(hash);
+      ::new (static_cast<void*>(slots_ + idx)) ValueType(std::forward<ArgTypes>(args)...);
+      if (ctrl_[idx] == ctrl_deleted)
+        --deleted_;
+      set_ctrl(idx, hash_tag(hash));
+      ++size_;
+      return std::make_pair(idx, true);
+    }
+    void set_ctrl(size_t idx, int8_t value) {
+      ctrl_[idx] = value;
+      if (idx < group_width) // the first group is mirrored after the end so groups never wrap
+        ctrl_[capacity_ + idx] = value;
+    }
+    void rehash(size_t capacity) {
+      int8_t* old_ctrl = ctrl_;
+      ValueType* old_slots = slots_;
+      const size_t old_capacity = capacity_;
+      ctrl_ = std::allocator<int8_t>().allocate(capacity + group_width);
+      slots_ = std::allocator<ValueType>().allocate(capacity);
+      capacity_ = capacity;
+      deleted_ = 0;
+      std::fill(ctrl_, ctrl_ + capacity + group_width, ctrl_empty);
+      for (size_t i = 0; i < old_capacity; ++i) {
+        if (old_ctrl[i] < 0)
+          continue;
+        const size_t hash = hasher_(KeyOfValueType()(old_slots[i]));
+        const size_t idx = find_unused(hash);
+        ::new (static_cast<void*>(slots_ + idx)) ValueType(std::move(old_slots[i]));
+        set_ctrl(idx, hash_tag(hash));
+        old_slots[i].~ValueType();
+      }
+      if (old_capacity != 0) {
+        std::allocator<int8_t>().deallocate(old_ctrl, old_capacity + group_width);
+        std::allocator<ValueType>().deallocate(old_slots, old_capacity);
+      }
+    }
+    iterator iterator_at(size_t idx) { return idx == npos ? end() : iterator(ctrl_ + idx, ctrl_ + capacity_, slots_ + idx); }
+    const_iterator iterator_at(size_t idx) const { return idx == npos ? end() : const_iterator(ctrl_ + idx, ctrl_ + capacity_, slots_ + idx); }
+    void destroy_elements() {
+      for (size_t i = 0; i < capacity_; ++i)
+        if (ctrl_[i] >= 0)
+          slots_[i].~ValueType();
+    }
+    void deallocate() {
+      if (capacity_ == 0)
+        return;
+      std::allocator<int8_t>().deallocate(ctrl_, capacity_ + group_width);
+      std::allocator<ValueType>().deallocate(slots_, capacity_);
+    }
+    int8_t* ctrl_;
+    ValueType* slots_;
+    size_t capacity_;
+    size_t size_;
+    size_t deleted_;
+    HashType hasher_;
+    EqualType equal_;
+  };
+
+  // hash_set - unique elements in a swiss_table
+  template <typename T, typename HashType = fast_hash<T>, typename EqualType = std::equal_to<T> >
+  class hash_set : public swiss_table<T, T, identity_key, HashType, EqualType> {
+    typedef swiss_table<T, T, identity_key, HashType, EqualType> table_type;
+  public:
+    typedef typename table_type::const_iterator iterator;
+    typedef typename table_type::const_iterator const_iterator;
+    hash_set() {}
+    template <typename InputIterator>
+    hash_set(InputIterator first, InputIterator last) {
+      insert(first, last);
+    }
+    hash_set(std::initializer_list<T> values) {
+      insert(values.begin(), values.end());
+    }
+    std::pair<const_iterator, bool> insert(const T& value) {
+      const auto& result = this->emplace_key(value, value);
+      return std::make_pair(this->iterator_at(result.first), result.second);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+      this->reserve_range(first, last);
+      for (; first != last; ++first)
+        this->emplace_key(*first, *first);
+    }
+    const_iterator find(const T& value) const { return table_type::find(value); }
+    const_iterator begin() const { return table_type::begin(); }
+    const_iterator end() const { return table_type::end(); }
+  };
+
+  // hash_map - unique keys and their values in a swiss_table
+  template <typename KeyType, typename ValueType, typename HashType = fast_hash<KeyType>, typename EqualType = std::equal_to<KeyType> >
+  class hash_map : public swiss_table<KeyType, std::pair<const KeyType, ValueType>, pair_first_key, HashType, EqualType> {
+    typedef swiss_table<KeyType, std::pair<const KeyType, ValueType>, pair_first_key, HashType, EqualType> table_type;
+  public:
+    typedef ValueType mapped_type;
+    typedef typename table_type::value_type value_type;
+    typedef typename table_type::iterator iterator;
+    typedef typename table_type::const_iterator const_iterator;
+    hash_map() {}
+    template <typename InputIterator>
+    hash_map(InputIterator first, InputIterator last) {
+      insert(first, last);
+    }
+    hash_map(std::initializer_list<value_type> values) {
+      insert(values.begin(), values.end());
+    }
+    std::pair<iterator, bool> insert(const value_type& value) {
+      const auto& result = this->emplace_key(value.first, value);
+      return std::make_pair(this->iterator_at(result.first), result.second);
+    }
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last) {
+      this->reserve_range(first, last);
+      for (; first != last; ++first)
+        this->emplace_key(first->first, *first);
+    }
+    ValueType& operator[](const KeyType& key) {
+      const auto& result = this->emplace_key(key, key, ValueType());
+      return this->slots_[result.first].second;
+    }
+    // try_emplace - constructs the value from args only when key is missing
+    template <typename... ArgTypes>
+    std::pair<iterator, bool> try_emplace(const KeyType& key, ArgTypes&&... args) {
+      const auto& result = this->emplace_key(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<ArgTypes>(args)...));
+      return std::make_pair(this->iterator_at(result.first), result.second);
+    }
+    ValueType& at(const KeyType& key) {
+      const auto& it = this->find(key);
+      UNDERSCORE_ASSERT(it != this->end());
+      return it->second;
+    }
+    const ValueType& at(const KeyType& key) const {
+      const auto& it = this->find(key);
+      UNDERSCORE_ASSERT(it != this->end());
+      return it->second;
+    }
+  };
+}
+CREATE_TAG_0_ARG( ToHashSetTag );
+template <typename ContainerType>
+UnderscoreDetail::hash_set<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToHashSetTag&) {
+  return UnderscoreDetail::hash_set<typename ContainerType::value_type>(std::begin(container), std::end(container));
+}
+namespace UnderscoreTags {
+  IMPLEMENTS_2_ARG_TAG( ToHashMapTag )
+  struct ToHashMapTag {
+    ToHashMapTag() {}
+    ToHashMapTag& operator=(const ToHashMapTag&);
+    IMPLEMENTS_2_ARG_OPERATOR( ToHashMapTag )
+  };
+}
+template <typename ContainerType> // container of pairs
+UnderscoreDetail::hash_map<
+  typename std::remove_const<typename ContainerType::value_type::first_type>::type,
+  typename ContainerType::value_type::second_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToHashMapTag&) {
+  typedef typename std::remove_const<typename ContainerType::value_type::first_type>::type KeyType;
+  typedef typename ContainerType::value_type::second_type ValueType;
+  return UnderscoreDetail::hash_map<KeyType, ValueType>(std::begin(container), std::end(container));
+}
+template <typename ContainerType, typename KeyFunctorType, typename ValueFunctorType> // key and value functors
+UnderscoreDetail::hash_map<
+  typename std::decay<typename std::result_of<KeyFunctorType(typename ContainerType::value_type)>::type>::type,
+  typename std::decay<typename std::result_of<ValueFunctorType(typename ContainerType::value_type)>::type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToHashMapTag2Arg<KeyFunctorType, ValueFunctorType>& tag) {
+  typedef typename std::decay<typename std::result_of<KeyFunctorType(typename ContainerType::value_type)>::type>::type KeyType;
+  typedef typename std::decay<typename std::result_of<ValueFunctorType(typename ContainerType::value_type)>::type>::type ValueType;
+  UnderscoreDetail::hash_map<KeyType, ValueType> dictionary;
+  dictionary.reserve(container.size());
+  for (auto it = std::begin(container); it != std::end(container); ++it)
+    dictionary.insert(std::make_pair(tag.arg0(*it), tag.arg1(*it)));
+  return dictionary;
+}
+template <typename ValueType, typename HashType, typename EqualType, typename ArgType0> // hash_set find
+typename UnderscoreDetail::hash_set<ValueType, HashType, EqualType>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::hash_set<ValueType, HashType, EqualType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename ValueType, typename HashType, typename EqualType, typename ArgType0>
+typename UnderscoreDetail::hash_set<ValueType, HashType, EqualType>::const_iterator
+PIPE_OPERATOR(UnderscoreDetail::hash_set<ValueType, HashType, EqualType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename KeyType, typename ValueType, typename HashType, typename EqualType, typename ArgType0> // immutable hash_map find
+typename UnderscoreDetail::hash_map<KeyType, ValueType, HashType, EqualType>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::hash_map<KeyType, ValueType, HashType, EqualType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename KeyType, typename ValueType, typename HashType, typename EqualType, typename ArgType0> // mutable hash_map find
+typename UnderscoreDetail::hash_map<KeyType, ValueType, HashType, EqualType>::iterator
+PIPE_OPERATOR(UnderscoreDetail::hash_map<KeyType, ValueType, HashType, EqualType>& container, const UnderscoreTags::FindTag1Arg<ArgType0>& tag) {
+  return container.find(tag.arg0);
+}
+template <typename ValueType, typename HashType, typename EqualType, typename ArgType0> // hash_set contains
+bool
+PIPE_OPERATOR(const UnderscoreDetail::hash_set<ValueType, HashType, EqualType>& container, const UnderscoreTags::AnyOfEqualTag1Arg<ArgType0>& tag) {
+  return container.contains(tag.arg0);
+}
+template <typename KeyType, typename ValueType, typename HashType, typename EqualType, typename ArgType0> // hash_map contains key
+bool
+PIPE_OPERATOR(const UnderscoreDetail::hash_map<KeyType, ValueType, HashType, EqualType>& container, const UnderscoreTags::AnyOfEqualTag1Arg<ArgType0>& tag) {
+  return container.contains(tag.arg0);
+}
+template <typename KeyType, typename ValueType, typename HashType, typename EqualType, typename ArgType0, typename ArgType1> // immutable hash_map value_or_default
+ValueType
+PIPE_OPERATOR(const UnderscoreDetail::hash_map<KeyType, ValueType, HashType, EqualType>& dictionary, const UnderscoreTags::ValueOrDefaultTag2Arg<ArgType0, ArgType1>& tag) {
+  const auto& it = dictionary.find(tag.arg0);
+  return it == dictionary.end() ? static_cast<ValueType>(tag.arg1) : it->second;
+}
+template <typename KeyType, typename ValueType, typename HashType, typename EqualType, typename ArgType0, typename ArgType1> // mutable hash_map value_or_default
+ValueType
+PIPE_OPERATOR(UnderscoreDetail::hash_map<KeyType, ValueType, HashType, EqualType>& dictionary, const UnderscoreTags::ValueOrDefaultTag2Arg<ArgType0, ArgType1>& tag) {
+  const auto& it = dictionary.find(tag.arg0);
+  return it == dictionary.end() ? static_cast<ValueType>(tag.arg1) : it->second;
+}
+
+
+/// bloom_filter, cuckoo_filter
+namespace UnderscoreDetail {
+  inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif UNDERSCORE_SSE2
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+  }
+  // fast_range - maps a 32 bit hash to [0, count) with a multiply instead of a division
+  inline size_t fast_range(uint32_t hash, size_t count) { return static_cast<size_t>((static_cast<uint64_t>(hash) * count) >> 32); }
+
+  // bloom_filter - blocked bloom filter, every key sets all of its bits inside a single 64 byte block
+  // so a query touches one cache line. Blocking costs some accuracy, which is bought back with ~20% more bits.
+  // The words are over-allocated by most of a block and the blocks start at the first 64 byte boundary,
+  // a copy moves the blocks to the boundary of its own words.
+  template <typename T>
+  class bloom_filter {
+  public:
+    typedef T value_type;
+    enum { block_bits = 512, block_words = block_bits / 64, batch_size = 16 };
+    explicit bloom_filter(size_t expected_count = 0, double false_positive_rate = 0.01) : block_count_(0), hash_count_(1) {
+      UNDERSCORE_ASSERT(false_positive_rate > 0 && false_positive_rate < 1);
+      const double bits_per_key = 1.2 * -std::log(false_positive_rate) / (std::log(2.0) * std::log(2.0));
+      const size_t bits = static_cast<size_t>(bits_per_key * static_cast<double>(std::max<size_t>(expected_count, 1))) + 1;
+      block_count_ = (bits + block_bits - 1) / block_bits;
+      words_.assign(block_count_ * block_words + block_words - 1, 0);
+      hash_count_ = static_cast<uint32_t>(std::min(std::max(bits_per_key / 1.2 * std::log(2.0) + 0.5, 1.0), 16.0));
+    }
+    template <typename IteratorType>
+    bloom_filter(IteratorType first, IteratorType last, double false_positive_rate)
+    : bloom_filter(static_cast<size_t>(std::distance(first, last)), false_positive_rate) {
+      for (; first != last; ++first)
+        insert(*first);
+    }
+    bloom_filter(const bloom_filter& other)
+    : words_(other.words_.size(), 0), block_count_(other.block_count_), hash_count_(other.hash_count_) {
+      std::copy(other.blocks(), other.blocks() + block_count_ * block_words, blocks());
+    }
+    bloom_filter(bloom_filter&& other)
+    : words_(std::move(other.words_)), block_count_(other.block_count_), hash_count_(other.hash_count_) {
+      other.words_.assign(2 * block_words - 1, 0); // a moved-from filter is left with one empty block, still queryable
+      other.block_count_ = 1;
+    }
+    bloom_filter& operator=(bloom_filter other) {
+      words_.swap(other.words_);
+      std::swap(block_count_, other.block_count_);
+      std::swap(hash_count_, other.hash_count_);
+      return *this;
+    }
+    template <typename KeyType>
+    void insert(const KeyType& key) {
+      const uint64_t hash = hash_value(key, 0);
+      uint64_t* block = block_of(hash);
+      uint32_t bit = static_cast<uint32_t>(hash);
+      const uint32_t step = static_cast<uint32_t>(multiply_fold(hash, hash_secret2)) | 1;
+      for (uint32_t i = 0; i < hash_count_; ++i, bit += step)
+        block[(bit >> 23) / 64] |= static_cast<uint64_t>(1) << ((bit >> 23) % 64);
+    }
+    // maybe_contains - false when key was never inserted, true when it probably was
+    template <typename KeyType>
+    bool maybe_contains(const KeyType& key) const { return test(hash_value(key, 0)); }
+    // maybe_contains - batch query, hashes and prefetches a batch of blocks before testing any of them
+    template <typename IteratorType, typename OutputIteratorType>
+    OutputIteratorType maybe_contains(IteratorType first, IteratorType last, OutputIteratorType out) const {
+      uint64_t hashes[batch_size];
+      while (first != last) {
+        size_t count = 0;
+        for (; first != last && count < batch_size; ++first, ++count) {
+          hashes[count] = hash_value(*first, 0);
+          prefetch(block_of(hashes[count]));
+        }
+        for (size_t i = 0; i < count; ++i)
+          *out++ = test(hashes[i]);
+      }
+      return out;
+    }
+    size_t size_in_bytes() const { return block_count_ * block_words * sizeof(uint64_t); }
+    uint32_t hash_count() const { return hash_count_; }
+  private:
+    // blocks - the first word on a 64 byte boundary
+    size_t first_block() const { return (0 - reinterpret_cast<uintptr_t>(words_.data()) / sizeof(uint64_t)) & (block_words - 1); }
+    const uint64_t* blocks() const { return words_.data() + first_block(); }
+    uint64_t* blocks() { return words_.data() + first_block(); }
+    const uint64_t* block_of(uint64_t hash) const { return blocks() + fast_range(static_cast<uint32_t>(hash >> 32), block_count_) * block_words; }
+    uint64_t* block_of(uint64_t hash) { return blocks() + fast_range(static_cast<uint32_t>(hash >> 32), block_count_) * block_words; }
+    bool test(uint64_t hash) const {
+      const uint64_t* block = block_of(hash);
+      uint32_t bit = static_cast<uint32_t>(hash);
+      const uint32_t step = static_cast<uint32_t>(multiply_fold(hash, hash_secret2)) | 1;
+      bool found = true;
+      for (uint32_t i = 0; i < hash_count_; ++i, bit += step)
+        found &= (block[(bit >> 23) / 64] >> ((bit >> 23) % 64)) & 1;
+      return found;
+    }
+    std::vector<uint64_t> words_;
+    size_t block_count_;
+    uint32_t hash_count_;
+  };
+
+  // cuckoo_filter - every key has a fingerprint stored in one of two buckets of four slots, either bucket is
+  // found from the other and the fingerprint. Unlike a bloom filter keys can be
+  // erased. A bucket is compared as one word, so fingerprints are only 8 or 16 bits: false positive rates of
+  // 3% and above get 8 bits (about 3% actual), lower rates get 16 bits, which bottom out at about 0.012%.
+  // Building from a range stores each distinct key once, so repeated keys don't overflow a bucket pair.
+  template <typename T>
+  class cuckoo_filter {
+  public:
+    typedef T value_type;
+    enum { slots_per_bucket = 4, max_kicks = 500, batch_size = 16 };
+    static double max_load() { return 0.9; }
+    explicit cuckoo_filter(size_t expected_count = 0, double false_positive_rate = 0.01)
+    : fingerprint_bytes_(false_positive_rate >= 0.03 ? 1 : 2), size_(0), has_victim_(false), victim_bucket_(0), victim_fingerprint_(0) {
+      UNDERSCORE_ASSERT(false_positive_rate > 0 && false_positive_rate < 1);
+      const size_t bucket_count = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(expected_count) / (slots_per_bucket * max_load())) + 1);
+      table_.assign(bucket_count * slots_per_bucket * fingerprint_bytes_, 0);
+    }
+    template <typename IteratorType>
+    cuckoo_filter(IteratorType first, IteratorType last, double false_positive_rate)
+    : cuckoo_filter(static_cast<size_t>(std::distance(first, last)), false_positive_rate) {
+      hash_set<T> seen; // by key, distinct keys may share a fingerprint and each needs its own slot to survive an erase
+      seen.reserve(static_cast<size_t>(std::distance(first, last)));
+      for (IteratorType it = first; it != last; ++it) {
+        if (!seen.insert(*it).second || insert(*it)) // a repeated key would take a slot of the same pair every time
+          continue;
+        *this = cuckoo_filter(bucket_count() * slots_per_bucket, false_positive_rate); // too full, start over with more room
+        seen.clear();
+        it = first;
+        seen.insert(*it);
+        insert(*it);
+      }
+    }
+    // insert - false when the filter is too full to take the key
+    template <typename KeyType>
+    bool insert(const KeyType& key) {
+      if (has_victim_)
+        return false;
+      size_t bucket = 0;
+      uint32_t fingerprint = 0;
+      locate(hash_value(key, 0), bucket, fingerprint);
+      ++size_;
+      if (add(bucket, fingerprint) || add(alternate(bucket, fingerprint), fingerprint))
+        return true;
+      std::minstd_rand random(static_cast<uint32_t>(size_));
+      for (int kick = 0; kick < max_kicks; ++kick) {
+        if (random() & 1)
+          bucket = alternate(bucket, fingerprint);
+        const size_t slot = bucket * slots_per_bucket + random() % slots_per_bucket;
+        const uint32_t evicted = get(slot);
+        set(slot, fingerprint);
+        fingerprint = evicted;
+        bucket = alternate(bucket, fingerprint);
+        if (add(bucket, fingerprint))
+          return true;
+      }
+      has_victim_ = true; // the last homeless fingerprint is kept aside, the filter is full from now on
+      victim_bucket_ = bucket;
+      victim_fingerprint_ = fingerprint;
+      return true;
+    }
+    template <typename KeyType>
+    bool erase(const KeyType& key) {
+      size_t bucket = 0;
+      uint32_t fingerprint = 0;
+      locate(hash_value(key, 0), bucket, fingerprint);
+      const size_t other = alternate(bucket, fingerprint);
+      if (has_victim_ && victim_fingerprint_ == fingerprint && (victim_bucket_ == bucket || victim_bucket_ == other))
+        has_victim_ = false;
+      else if (!remove(bucket, fingerprint) && !remove(other, fingerprint))
+        return false;
+      --size_;
+      if (has_victim_ && add(victim_bucket_, victim_fingerprint_))
+        has_victim_ = false;
+      return true;
+    }
+    template <typename KeyType>
+    bool maybe_contains(const KeyType& key) const {
+      size_t bucket = 0;
+      uint32_t fingerprint = 0;
+      locate(hash_value(key, 0), bucket, fingerprint);
+      return test(bucket, fingerprint);
+    }
+    template <typename IteratorType, typename OutputIteratorType>
+    OutputIteratorType maybe_contains(IteratorType first, IteratorType last, OutputIteratorType out) const {
+      size_t buckets[batch_size];
+      uint32_t fingerprints[batch_size];
+      while (first != last) {
+        size_t count = 0;
+        for (; first != last && count < batch_size; ++first, ++count) {
+          locate(hash_value(*first, 0), buckets[count], fingerprints[count]);
+          prefetch(table_.data() + buckets[count] * slots_per_bucket * fingerprint_bytes_);
+          prefetch(table_.data() + alternate(buckets[count], fingerprints[count]) * slots_per_bucket * fingerprint_bytes_);
+        }
+        for (size_t i = 0; i < count; ++i)
+          *out++ = test(buckets[i], fingerprints[i]);
+      }
+      return out;
+    }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t size_in_bytes() const { return table_.size(); }
+  private:
+    size_t bucket_count() const { return table_.size() / (slots_per_bucket * fingerprint_bytes_); }
+    void locate(uint64_t hash, size_t& bucket, uint32_t& fingerprint) const {
+      const uint32_t mask = fingerprint_bytes_ == 1 ? 0xff : 0xffff;
+      fingerprint = static_cast<uint32_t>(hash >> 32) & mask;
+      fingerprint += fingerprint == 0 ? 1 : 0; // zero marks an empty slot
+      bucket = fast_range(static_cast<uint32_t>(hash), bucket_count());
+    }
+    // alternate - (hash(fingerprint) - bucket) mod buckets, which maps each bucket of a pair to the other
+    // without needing a power of two bucket count
+    size_t alternate(size_t bucket, uint32_t fingerprint) const {
+      const size_t count = bucket_count();
+      return (static_cast<size_t>(fingerprint * 0x5bd1e995u) % count + count - bucket) % count;
+    }
+    uint32_t get(size_t slot) const {
+      if (fingerprint_bytes_ == 1)
+        return table_[slot];
+      return table_[slot * 2] | static_cast<uint32_t>(table_[slot * 2 + 1]) << 8;
+    }
+    void set(size_t slot, uint32_t fingerprint) {
+      if (fingerprint_bytes_ == 1)
+        table_[slot] = static_cast<uint8_t>(fingerprint);
+      else {
+        table_[slot * 2] = static_cast<uint8_t>(fingerprint);
+        table_[slot * 2 + 1] = static_cast<uint8_t>(fingerprint >> 8);
+      }
+    }
+    bool add(size_t bucket, uint32_t fingerprint) {
+      for (size_t slot = bucket * slots_per_bucket; slot < (bucket + 1) * slots_per_bucket; ++slot) {
+        if (get(slot) == 0) {
+          set(slot, fingerprint);
+          return true;
+        }
+      }
+      return false;
+    }
+    bool remove(size_t bucket, uint32_t fingerprint) {
+      for (size_t slot = bucket * slots_per_bucket; slot < (bucket + 1) * slots_per_bucket; ++slot) {
+        if (get(slot) == fingerprint) {
+          set(slot, 0);
+          return true;
+        }
+      }
+      return false;
+    }
+    // bucket_contains - the four slots as one word, a slot equal to the fingerprint becomes a zero lane
+    bool bucket_contains(size_t bucket, uint32_t fingerprint) const {
+      const uint8_t* bytes = table_.data() + bucket * slots_per_bucket * fingerprint_bytes_;
+      if (fingerprint_bytes_ == 1) {
+        uint32_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        word ^= fingerprint * 0x01010101u;
+        return ((word - 0x01010101u) & ~word & 0x80808080u) != 0;
+      }
+      uint64_t word;
+      std::memcpy(&word, bytes, sizeof(word));
+      word ^= fingerprint * 0x0001000100010001ULL;
+      return ((word - 0x0001000100010001ULL) & ~word & 0x8000800080008000ULL) != 0;
+    }
+    bool test(size_t bucket, uint32_t fingerprint) const {
+      const size_t other = alternate(bucket, fingerprint);
+      return bucket_contains(bucket, fingerprint) || bucket_contains(other, fingerprint) ||
+        (has_victim_ && victim_fingerprint_ == fingerprint && (victim_bucket_ == bucket || victim_bucket_ == other));
+    }
+    std::vector<uint8_t> table_;
+    size_t fingerprint_bytes_;
+    size_t size_;
+    bool has_victim_;
+    size_t victim_bucket_;
+    uint32_t victim_fingerprint_;
+  };
+}
+CREATE_TAG_0_1_ARG( ToBloomFilterTag );
+template <typename ContainerType>
+UnderscoreDetail::bloom_filter<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToBloomFilterTag&) {
+  return UnderscoreDetail::bloom_filter<typename ContainerType::value_type>(std::begin(container), std::end(container), 0.01);
+}
+template <typename ContainerType, typename ArgType0> // false positive rate
+UnderscoreDetail::bloom_filter<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToBloomFilterTag1Arg<ArgType0>& tag) {
+  return UnderscoreDetail::bloom_filter<typename ContainerType::value_type>(std::begin(container), std::end(container), static_cast<double>(tag.arg0));
+}
+CREATE_TAG_0_1_ARG( ToCuckooFilterTag );
+template <typename ContainerType>
+UnderscoreDetail::cuckoo_filter<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToCuckooFilterTag&) {
+  return UnderscoreDetail::cuckoo_filter<typename ContainerType::value_type>(std::begin(container), std::end(container), 0.01);
+}
+template <typename ContainerType, typename ArgType0> // false positive rate
+UnderscoreDetail::cuckoo_filter<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToCuckooFilterTag1Arg<ArgType0>& tag) {
+  return UnderscoreDetail::cuckoo_filter<typename ContainerType::value_type>(std::begin(container), std::end(container), static_cast<double>(tag.arg0));
+}
+CREATE_TAG_1_ARG( MaybeContainsTag );
+template <typename FilterType, typename ArgType0> // bloom_filter or cuckoo_filter
+bool
+PIPE_OPERATOR(const FilterType& filter, const UnderscoreTags::MaybeContainsTag1Arg<ArgType0>& tag) {
+  return filter.maybe_contains(tag.arg0);
+}
+CREATE_TAG_1_ARG( MaybeContainsEachTag );
+template <typename FilterType, typename ArgType0> // filter, container of keys
+std::vector<bool>
+PIPE_OPERATOR(const FilterType& filter, const UnderscoreTags::MaybeContainsEachTag1Arg<ArgType0>& tag) {
+  std::vector<bool> results;
+  results.reserve(tag.arg0.size());
+  filter.maybe_contains(std::begin(tag.arg0), std::end(tag.arg0), std::back_inserter(results));
+  return results;
+}
+
+/// to_eytzinger, lower_bound_batch
+namespace UnderscoreDetail {
+  // eytzinger_array - sorted values in the breadth first order of the implicit search tree, element k has its children
+  // at 2k and 2k + 1. The top of the tree shares a few cache lines and the descendants a few levels down are adjacent,
+  // so one prefetch per step keeps the search ahead of memory. Iteration is in layout order, not sorted order.
+  template <typename T>
+  class eytzinger_array {
+  public:
+    typedef T value_type;
+    typedef typename std::vector<T>::const_iterator iterator;
+    typedef iterator const_iterator;
+    eytzinger_array() : tree_(1) {}
+    template <typename IteratorType> // sorted
+    eytzinger_array(IteratorType first, IteratorType last) : tree_(1 + static_cast<size_t>(std::distance(first, last))) {
+      fill(first, 1);
+    }
+    size_t size() const { return tree_.size() - 1; }
+    bool empty() const { return tree_.size() == 1; }
+    const_iterator begin() const { return tree_.begin() + 1; }
+    const_iterator end() const { return tree_.end(); }
+    template <typename ValueType>
+    const_iterator lower_bound(const ValueType& value) const { return at(descend(value, 1, less_than_value())); }
+    template <typename ValueType>
+    const_iterator upper_bound(const ValueType& value) const { return at(descend(value, 1, not_greater_than_value())); }
+    template <typename ValueType>
+    bool contains(const ValueType& value) const {
+      const auto& it = lower_bound(value);
+      return it != end() && !(value < *it);
+    }
+    // lower_bounds - interleaves the descents of several values, whose loads are independent and overlap in memory
+    template <typename IteratorType, typename OutputIteratorType>
+    void lower_bounds(IteratorType first, IteratorType last, OutputIteratorType out) const {
+      const size_t group_size = 16;
+      size_t nodes[group_size];
+      while (first != last) {
+        IteratorType group_first = first;
+        size_t count = 0;
+        for (; first != last && count < group_size; ++first)
+          nodes[count++] = 1;
+        for (bool descending = true; descending; ) {
+          descending = false;
+          IteratorType value = group_first;
+          for (size_t g = 0; g < count; ++g, ++value) {
+            if (nodes[g] < tree_.size()) {
+              nodes[g] = 2 * nodes[g] + (tree_[nodes[g]] < *value ? 1 : 0);
+              prefetch(tree_.data() + prefetch_node(nodes[g]));
+              descending = true;
+            }
+          }
+        }
+        for (size_t g = 0; g < count; ++g)
+          *out++ = at(leaf_to_node(nodes[g]));
+      }
+    }
+  private:
+    struct less_than_value {
+      template <typename A, typename B>
+      bool operator()(const A& node, const B& value) const { return node < value; }
+    };
+    struct not_greater_than_value {
+      template <typename A, typename B>
+      bool operator()(const A& node, const B& value) const { return !(value < node); }
+    };
+    // A cache line holds the descendants this many levels down
+    static size_t prefetch_stride() { return sizeof(T) <= 4 ? 16 : sizeof(T) <= 8 ? 8 : sizeof(T) <= 16 ? 4 : 2; }
+    size_t prefetch_node(size_t node) const {
+      const size_t ahead = node * prefetch_stride();
+      return ahead < tree_.size() ? ahead : 0;
+    }
+    // descend - goes right while go_right holds, the answer is the last node where it went left, found by dropping
+    // the trailing right turns and that left turn from the leaf index
+    template <typename ValueType, typename GoRightType>
+    size_t descend(const ValueType& value, size_t node, GoRightType go_right) const {
+      while (node < tree_.size()) {
+        prefetch(tree_.data() + prefetch_node(node));
+        node = 2 * node + (go_right(tree_[node], value) ? 1 : 0);
+      }
+      return leaf_to_node(node);
+    }
+    static size_t leaf_to_node(size_t leaf) { return leaf >> (count_trailing_zeros(~static_cast<uint64_t>(leaf)) + 1); }
+    const_iterator at(size_t node) const { return node == 0 ? end() : tree_.begin() + static_cast<ptrdiff_t>(node); }
+    template <typename IteratorType>
+    void fill(IteratorType& it, size_t node) {
+      if (node >= tree_.size())
+        return;
+      fill(it, 2 * node);
+      tree_[node] = *it;
+      ++it;
+      fill(it, 2 * node + 1);
+    }
+    std::vector<T> tree_; // tree_[0] is unused so the root is 1
+  };
+
+  // lower_bound_batch - branchless searches of a group of values in lockstep, every search halves the same length
+  // so the group shares the loop and its independent loads are in flight together
+  template <typename IteratorType, typename ValuesIteratorType, typename OutputIteratorType>
+  void lower_bound_batch(IteratorType first, IteratorType last, ValuesIteratorType values_first, ValuesIteratorType values_last, OutputIteratorType out, std::random_access_iterator_tag) {
+    const size_t group_size = 16;
+    IteratorType bases[group_size];
+    const auto size = last - first;
+    while (values_first != values_last) {
+      ValuesIteratorType group_first = values_first;
+      size_t count = 0;
+      for (; values_first != values_last && count < group_size; ++values_first)
+        bases[count++] = first;
+      if (size == 0) {
+        for (size_t g = 0; g < count; ++g)
+          *out++ = first;
+        continue;
+      }
+      for (auto length = size; length > 1; ) {
+        const auto half = length / 2;
+        ValuesIteratorType value = group_first;
+        for (size_t g = 0; g < count; ++g, ++value)
+          bases[g] = bases[g][half] < *value ? bases[g] + half : bases[g];
+        length -= half;
+      }
+      ValuesIteratorType value = group_first;
+      for (size_t g = 0; g < count; ++g, ++value)
+        *out++ = *bases[g] < *value ? bases[g] + 1 : bases[g];
+    }
+  }
+  template <typename IteratorType, typename ValuesIteratorType, typename OutputIteratorType>
+  void lower_bound_batch(IteratorType first, IteratorType last, ValuesIteratorType values_first, ValuesIteratorType values_last, OutputIteratorType out, std::forward_iterator_tag) {
+    for (; values_first != values_last; ++values_first)
+      *out++ = std::lower_bound(first, last, *values_first);
+  }
+}
+CREATE_TAG_0_ARG( ToEytzingerTag );
+template <typename ContainerType>
+UnderscoreDetail::eytzinger_array<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ToEytzingerTag&) {
+  std::vector<typename ContainerType::value_type> sorted(std::begin(container), std::end(container));
+  if (!std::is_sorted(sorted.begin(), sorted.end()))
+    std::sort(sorted.begin(), sorted.end());
+  return UnderscoreDetail::eytzinger_array<typename ContainerType::value_type>(sorted.begin(), sorted.end());
+}
+template <typename T, typename ArgType0> // eytzinger_array lower_bound
+typename UnderscoreDetail::eytzinger_array<T>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::eytzinger_array<T>& container, const UnderscoreTags::LowerBoundTag1Arg<ArgType0>& tag) {
+  return container.lower_bound(tag.arg0);
+}
+template <typename T, typename ArgType0>
+typename UnderscoreDetail::eytzinger_array<T>::const_iterator
+PIPE_OPERATOR(UnderscoreDetail::eytzinger_array<T>& container, const UnderscoreTags::LowerBoundTag1Arg<ArgType0>& tag) {
+  return container.lower_bound(tag.arg0);
+}
+template <typename T, typename ArgType0> // eytzinger_array upper_bound
+typename UnderscoreDetail::eytzinger_array<T>::const_iterator
+PIPE_OPERATOR(const UnderscoreDetail::eytzinger_array<T>& container, const UnderscoreTags::UpperBoundTag1Arg<ArgType0>& tag) {
+  return container.upper_bound(tag.arg0);
+}
+template <typename T, typename ArgType0>
+typename UnderscoreDetail::eytzinger_array<T>::const_iterator
+PIPE_OPERATOR(UnderscoreDetail::eytzinger_array<T>& container, const UnderscoreTags::UpperBoundTag1Arg<ArgType0>& tag) {
+  return container.upper_bound(tag.arg0);
+}
+template <typename T, typename ArgType0> // eytzinger_array binary_search
+bool
+PIPE_OPERATOR(const UnderscoreDetail::eytzinger_array<T>& container, const UnderscoreTags::BinarySearchTag1Arg<ArgType0>& tag) {
+  return container.contains(tag.arg0);
+}
+CREATE_TAG_1_ARG( LowerBoundBatchTag );
+template <typename ContainerType, typename ArgType0> // sorted container, values to search for
+std::vector<typename ContainerType::const_iterator>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::LowerBoundBatchTag1Arg<ArgType0>& tag) {
+  typedef typename ContainerType::const_iterator IteratorType;
+  std::vector<IteratorType> result;
+  result.reserve(static_cast<size_t>(std::distance(std::begin(tag.arg0), std::end(tag.arg0))));
+  UnderscoreDetail::lower_bound_batch(IteratorType(std::begin(container)), IteratorType(std::end(container)), std::begin(tag.arg0), std::end(tag.arg0),
+    std::back_inserter(result), typename std::iterator_traits<IteratorType>::iterator_category());
+  return result;
+}
+template <typename T, typename ArgType0>
+std::vector<typename UnderscoreDetail::eytzinger_array<T>::const_iterator>
+PIPE_OPERATOR(const UnderscoreDetail::eytzinger_array<T>& container, const UnderscoreTags::LowerBoundBatchTag1Arg<ArgType0>& tag) {
+  std::vector<typename UnderscoreDetail::eytzinger_array<T>::const_iterator> result;
+  result.reserve(static_cast<size_t>(std::distance(std::begin(tag.arg0), std::end(tag.arg0))));
+  container.lower_bounds(std::begin(tag.arg0), std::end(tag.arg0), std::back_inserter(result));
+  return result;
+}
+
+/// set_union, set_intersection, set_difference, set_symmetric_difference
+namespace UnderscoreDetail {
+  const static size_t gallop_ratio = 32; // gallop through the larger range when it is this many times larger
+
+  // gallop_lower_bound - exponential search from first, cheap when the result is close to first
+  template <typename IteratorType, typename ValueType>
+  IteratorType
+  gallop_lower_bound(IteratorType first, IteratorType last, const ValueType& value) {
+    const auto length = last - first;
+    if (length == 0 || !(*first < value))
+      return first;
+    decltype(last - first) bound = 1;
+    while (bound < length && first[bound] < value)
+      bound *= 2;
+    return branchless_lower_bound(first + (bound / 2 + 1), first + std::min(bound, length), value, less_than());
+  }
+
+  // Galloping set operations, the larger range is only visited around the elements of the smaller
+  template <typename LargeIteratorType, typename SmallIteratorType, typename OutputIteratorType>
+  OutputIteratorType
+  gallop_union_skewed(LargeIteratorType large_first, LargeIteratorType large_last, SmallIteratorType small_first, SmallIteratorType small_last, OutputIteratorType out) {
+    for (; small_first != small_last; ++small_first) {
+      const auto& pos = gallop_lower_bound(large_first, large_last, *small_first);
+      out = std::copy(large_first, pos, out);
+      large_first = pos;
+      if (large_first != large_last && !(*small_first < *large_first))
+        *out++ = *large_first++;
+      else
+        *out++ = *small_first;
+    }
+    return std::copy(large_first, large_last, out);
+  }
+  template <typename LargeIteratorType, typename SmallIteratorType, typename OutputIteratorType>
+  OutputIteratorType
+  gallop_symmetric_difference_skewed(LargeIteratorType large_first, LargeIteratorType large_last, SmallIteratorType small_first, SmallIteratorType small_last, OutputIteratorType out) {
+    for (; small_first != small_last; ++small_first) {
+      const auto& pos = gallop_lower_bound(large_first, large_last, *small_first);
+      out = std::copy(large_first, pos, out);
+      large_first = pos;
+      if (large_first != large_last && !(*small_first < *large_first))
+        ++large_first;
+      else
+        *out++ = *small_first;
+    }
+    return std::copy(large_first, large_last, out);
+  }
+  template <typename LargeIteratorType, typename SmallIteratorType, typename OutputIteratorType>
+  OutputIteratorType
+  gallop_intersection_skewed(LargeIteratorType large_first, LargeIteratorType large_last, SmallIteratorType small_first, SmallIteratorType small_last, OutputIteratorType out) {
+    for (; small_first != small_last && large_first != large_last; ++small_first) {
+      large_first = gallop_lower_bound(large_first, large_last, *small_first);
+      if (large_first != large_last && !(*small_first < *large_first))
+        *out++ = *large_first++;
+    }
+    return out;
+  }
+
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType, typename Category1, typename Category2>
+  OutputIteratorType
+  gallop_union(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, Category1, Category2) {
+    return std::set_union(first1, last1, first2, last2, out);
+  }
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType>
+  OutputIteratorType
+  gallop_union(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, std::random_access_iterator_tag, std::random_access_iterator_tag) {
+    const size_t size1 = static_cast<size_t>(last1 - first1);
+    const size_t size2 = static_cast<size_t>(last2 - first2);
+    if (size1 * gallop_ratio < size2)
+      return gallop_union_skewed(first2, last2, first1, last1, out);
+    if (size2 * gallop_ratio < size1)
+      return gallop_union_skewed(first1, last1, first2, last2, out);
+    return std::set_union(first1, last1, first2, last2, out);
+  }
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType, typename Category1, typename Category2>
+  OutputIteratorType
+  gallop_intersection(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, Category1, Category2) {
+    return std::set_intersection(first1, last1, first2, last2, out);
+  }
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType>
+  OutputIteratorType
+  gallop_intersection(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, std::random_access_iterator_tag, std::random_access_iterator_tag) {
+    const size_t size1 = static_cast<size_t>(last1 - first1);
+    const size_t size2 = static_cast<size_t>(last2 - first2);
+    if (size1 * gallop_ratio < size2)
+      return gallop_intersection_skewed(first2, last2, first1, last1, out);
+    if (size2 * gallop_ratio < size1)
+      return gallop_intersection_skewed(first1, last1, first2, last2, out);
+    return std::set_intersection(first1, last1, first2, last2, out);
+  }
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType, typename Category1, typename Category2>
+  OutputIteratorType
+  gallop_difference(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, Category1, Category2) {
+    return std::set_difference(first1, last1, first2, last2, out);
+  }
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType>
+  OutputIteratorType
+  gallop_difference(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, std::random_access_iterator_tag, std::random_access_iterator_tag) {
+    const size_t size1 = static_cast<size_t>(last1 - first1);
+    const size_t size2 = static_cast<size_t>(last2 - first2);
+    if (size1 * gallop_ratio < size2) { // few elements to keep or drop, search for each of them
+      for (; first1 != last1; ++first1) {
+        first2 = gallop_lower_bound(first2, last2, *first1);
+        if (first2 != last2 && !(*first1 < *first2))
+          ++first2;
+        else
+          *out++ = *first1;
+      }
+      return out;
+    }
+    if (size2 * gallop_ratio < size1) { // few elements to drop, copy the runs between them
+      for (; first2 != last2; ++first2) {
+        const auto& pos = gallop_lower_bound(first1, last1, *first2);
+        out = std::copy(first1, pos, out);
+        first1 = pos;
+        if (first1 != last1 && !(*first2 < *first1))
+          ++first1;
+      }
+      return std::copy(first1, last1, out);
+    }
+    return std::set_difference(first1, last1, first2, last2, out);
+  }
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType, typename Category1, typename Category2>
+  OutputIteratorType
+  gallop_symmetric_difference(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, Category1, Category2) {
+    return std::set_symmetric_difference(first1, last1, first2, last2, out);
+  }
+  template <typename Iterator1, typename Iterator2, typename OutputIteratorType>
+  OutputIteratorType
+  gallop_symmetric_difference(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2, OutputIteratorType out, std::random_access_iterator_tag, std::random_access_iterator_tag) {
+    const size_t size1 = static_cast<size_t>(last1 - first1);
+    const size_t size2 = static_cast<size_t>(last2 - first2);
+    if (size1 * gallop_ratio < size2)
+      return gallop_symmetric_difference_skewed(first2, last2, first1, last1, out);
+    if (size2 * gallop_ratio < size1)
+      return gallop_symmetric_difference_skewed(first1, last1, first2, last2, out);
+    return std::set_symmetric_difference(first1, last1, first2, last2, out);
+  }
+
+#if UNDERSCORE_SSE2
+  // intersect_sorted_unique_sse2 - compares blocks of four against all four rotations of the other block,
+  // both ranges must be strictly increasing
+  template <typename T>
+  size_t
+  intersect_sorted_unique_sse2(const T* a, size_t size_a, const T* b, size_t size_b, T* out) {
+    UNDERSCORE_STATIC_ASSERT(sizeof(T) == 4 && std::is_integral<T>::value, "");
+    size_t i = 0;
+    size_t j = 0;
+    size_t count = 0;
+    const size_t blocks_a = size_a & ~static_cast<size_t>(3);
+    const size_t blocks_b = size_b & ~static_cast<size_t>(3);
+    while (i < blocks_a && j < blocks_b) {
+      const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+      __m128i equal = _mm_cmpeq_epi32(va, vb);
+      equal = _mm_or_si128(equal, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+      equal = _mm_or_si128(equal, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+      equal = _mm_or_si128(equal, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+      for (uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(equal))); mask != 0; mask &= mask - 1)
+        out[count++] = a[i + count_trailing_zeros(mask)];
+      const T max_a = a[i + 3];
+      const T max_b = b[j + 3];
+      if (!(max_b < max_a))
+        i += 4;
+      if (!(max_a < max_b))
+        j += 4;
+    }
+    while (i < size_a && j < size_b) {
+      if (a[i] < b[j])
+        ++i;
+      else if (b[j] < a[i])
+        ++j;
+      else {
+        out[count++] = a[i];
+        ++i;
+        ++j;
+      }
+    }
+    return count;
+  }
+#endif
+
+  // flat_set_intersection - uses the SSE2 block intersection for sets of 32 bit integers
+  template <typename T, typename AllocType>
+  void
+  flat_set_intersection(const std::vector<T, AllocType>& a, const std::vector<T, AllocType>& b, std::vector<T, AllocType>& result, std::false_type) {
+    gallop_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result), std::random_access_iterator_tag(), std::random_access_iterator_tag());
+  }
+  template <typename T, typename AllocType>
+  void
+  flat_set_intersection(const std::vector<T, AllocType>& a, const std::vector<T, AllocType>& b, std::vector<T, AllocType>& result, std::true_type) {
+#if UNDERSCORE_SSE2
+    if (a.size() * gallop_ratio >= b.size() && b.size() * gallop_ratio >= a.size()) {
+      result.resize(std::min(a.size(), b.size()));
+      result.resize(intersect_sorted_unique_sse2(a.data(), a.size(), b.data(), b.size(), result.data()));
+      return;
+    }
+#endif
+    flat_set_intersection(a, b, result, std::false_type());
+  }
+
+  enum set_operation_type {
+    set_union_operation,
+    set_intersection_operation,
+    set_difference_operation,
+    set_symmetric_difference_operation
+  };
+
+  // set_operation_iterator - computes the next element of a set operation on increment
+  template <typename Iterator1, typename Iterator2, int Operation>
+  class set_operation_iterator {
+    typedef std::integral_constant<int, Operation> operation_type;
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::iterator_traits<Iterator1>::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+    set_operation_iterator(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2)
+    : first1_(first1)
+    , last1_(last1)
+    , first2_(first2)
+    , last2_(last2)
+    , from_first_(true) {
+      settle(operation_type());
+    }
+    reference operator*() const { return from_first_ ? *first1_ : *first2_; }
+    pointer operator->() const { return &**this; }
+    set_operation_iterator& operator++() {
+      advance(operation_type());
+      settle(operation_type());
+      return *this;
+    }
+    set_operation_iterator operator++(int) {
+      set_operation_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+    bool operator==(const set_operation_iterator& other) const { return first1_ == other.first1_ && first2_ == other.first2_; }
+    bool operator!=(const set_operation_iterator& other) const { return !(*this == other); }
+  private:
+    typedef std::integral_constant<int, set_union_operation> union_type;
+    typedef std::integral_constant<int, set_intersection_operation> intersection_type;
+    typedef std::integral_constant<int, set_difference_operation> difference_type_;
+    typedef std::integral_constant<int, set_symmetric_difference_operation> symmetric_difference_type;
+    void settle(union_type) {
+      from_first_ = first1_ != last1_ && (first2_ == last2_ || !(*first2_ < *first1_));
+    }
+    void advance(union_type) {
+      if (!from_first_) {
+        ++first2_;
+        return;
+      }
+      if (first2_ != last2_ && !(*first1_ < *first2_))
+        ++first2_;
+      ++first1_;
+    }
+    void settle(intersection_type) {
+      while (first1_ != last1_ && first2_ != last2_) {
+        if (*first1_ < *first2_)
+          ++first1_;
+        else if (*first2_ < *first1_)
+          ++first2_;
+        else
+          return;
+      }
+      first1_ = last1_;
+      first2_ = last2_;
+    }
+    void advance(intersection_type) {
+      ++first1_;
+      ++first2_;
+    }
+    void settle(difference_type_) {
+      while (first1_ != last1_ && first2_ != last2_) {
+        if (*first1_ < *first2_)
+          return;
+        if (*first2_ < *first1_)
+          ++first2_;
+        else {
+          ++first1_;
+          ++first2_;
+        }
+      }
+      if (first1_ == last1_)
+        first2_ = last2_;
+    }
+    void advance(difference_type_) {
+      ++first1_;
+    }
+    void settle(symmetric_difference_type) {
+      while (first1_ != last1_ && first2_ != last2_) {
+        if (*first1_ < *first2_) {
+          from_first_ = true;
+          return;
+        }
+        if (*first2_ < *first1_) {
+          from_first_ = false;
+          return;
+        }
+        ++first1_;
+        ++first2_;
+      }
+      from_first_ = first1_ != last1_;
+    }
+    void advance(symmetric_difference_type) {
+      if (from_first_)
+        ++first1_;
+      else
+        ++first2_;
+    }
+    Iterator1 first1_;
+    Iterator1 last1_;
+    Iterator2 first2_;
+    Iterator2 last2_;
+    bool from_first_;
+  };
+
+  // set_operation_view - lazy set operation on two sorted ranges, refers to both ranges
+  template <typename Iterator1, typename Iterator2, int Operation>
+  class set_operation_view {
+  public:
+    typedef set_operation_iterator<Iterator1, Iterator2, Operation> iterator;
+    typedef iterator const_iterator;
+    typedef typename iterator::value_type value_type;
+    set_operation_view(Iterator1 first1, Iterator1 last1, Iterator2 first2, Iterator2 last2)
+    : first1_(first1)
+    , last1_(last1)
+    , first2_(first2)
+    , last2_(last2)
+    {}
+    iterator begin() const { return iterator(first1_, last1_, first2_, last2_); }
+    iterator end() const { return iterator(last1_, last1_, last2_, last2_); }
+    bool empty() const { return begin() == end(); }
+  private:
+    Iterator1 first1_;
+    Iterator1 last1_;
+    Iterator2 first2_;
+    Iterator2 last2_;
+  };
+}
+#define CREATE_SET_OPERATION_PIPES(TAG_NAME, VIEW_TAG_NAME, FUNCTION, OPERATION) \
+  CREATE_TAG_1_ARG( TAG_NAME ); \
+  CREATE_TAG_1_ARG( VIEW_TAG_NAME ); \
+  template <typename ContainerType, typename ArgType0> \
+  std::vector<typename ContainerType::value_type, typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type> \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TAG_NAME##1Arg<ArgType0>& tag) { \
+    typedef UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type> AllocatorFor; \
+    std::vector<typename ContainerType::value_type, typename AllocatorFor::type> result(AllocatorFor::get(container)); \
+    UnderscoreDetail::FUNCTION( \
+      std::begin(container), std::end(container), std::begin(tag.arg0), std::end(tag.arg0), std::back_inserter(result), \
+      typename std::iterator_traits<decltype(std::begin(container))>::iterator_category(), \
+      typename std::iterator_traits<decltype(std::begin(tag.arg0))>::iterator_category()); \
+    return result; \
+  } \
+  template <typename ContainerType, typename ArgType0> \
+  UnderscoreDetail::set_operation_view<typename ContainerType::const_iterator, typename ArgType0::const_iterator, UnderscoreDetail::OPERATION> \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::VIEW_TAG_NAME##1Arg<ArgType0>& tag) { \
+    return UnderscoreDetail::set_operation_view<typename ContainerType::const_iterator, typename ArgType0::const_iterator, UnderscoreDetail::OPERATION>( \
+      container.begin(), container.end(), tag.arg0.begin(), tag.arg0.end()); \
+  }
+#define CREATE_FLAT_SET_OPERATION_PIPE(TAG_NAME, FUNCTION) \
+  template <typename ValueType, typename AllocType> \
+  UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType> \
+  PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType>& container, const UnderscoreTags::TAG_NAME##1Arg<UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType> >& tag) { \
+    typename UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType>::container_type result(container.get_allocator()); \
+    UnderscoreDetail::FUNCTION( \
+      container.begin(), container.end(), tag.arg0.begin(), tag.arg0.end(), std::back_inserter(result), \
+      std::random_access_iterator_tag(), std::random_access_iterator_tag()); \
+    return UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType>(UnderscoreDetail::sorted_unique_t(), std::move(result), container.key_comp()); \
+  }
+CREATE_SET_OPERATION_PIPES( SetUnionTag, SetUnionViewTag, gallop_union, set_union_operation );
+CREATE_SET_OPERATION_PIPES( SetIntersectionTag, SetIntersectionViewTag, gallop_intersection, set_intersection_operation );
+CREATE_SET_OPERATION_PIPES( SetDifferenceTag, SetDifferenceViewTag, gallop_difference, set_difference_operation );
+CREATE_SET_OPERATION_PIPES( SetSymmetricDifferenceTag, SetSymmetricDifferenceViewTag, gallop_symmetric_difference, set_symmetric_difference_operation );
+CREATE_FLAT_SET_OPERATION_PIPE( SetUnionTag, gallop_union );
+CREATE_FLAT_SET_OPERATION_PIPE( SetDifferenceTag, gallop_difference );
+CREATE_FLAT_SET_OPERATION_PIPE( SetSymmetricDifferenceTag, gallop_symmetric_difference );
+template <typename ValueType, typename AllocType> // flat_set of 32 bit integers, SIMD intersection
+UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType>
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType>& container, const UnderscoreTags::SetIntersectionTag1Arg<UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType> >& tag) {
+  typedef std::integral_constant<bool, std::is_integral<ValueType>::value && sizeof(ValueType) == 4> UseSimd;
+  typename UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType>::container_type result(container.get_allocator());
+  UnderscoreDetail::flat_set_intersection(container.elements(), tag.arg0.elements(), result, UseSimd());
+  return UnderscoreDetail::flat_set<ValueType, std::less<ValueType>, AllocType>(UnderscoreDetail::sorted_unique_t(), std::move(result), container.key_comp());
+}
+
+
+/// interpolation_search, exponential_search
+namespace UnderscoreDetail {
+  // interpolation_lower_bound - probes where the value would be if the keys were evenly spread, O(log log n) probes
+  // for near uniform keys. A probe that fails to halve the range is followed by a bisection, so skewed keys still
+  // need at most about twice the probes of a binary search.
+  template <typename IteratorType, typename ValueType>
+  IteratorType
+  interpolation_lower_bound(IteratorType first, IteratorType last, const ValueType& value) {
+    typedef typename std::iterator_traits<IteratorType>::value_type KeyType;
+    UNDERSCORE_STATIC_ASSERT(std::is_arithmetic<KeyType>::value, "interpolation_search needs arithmetic keys");
+    const size_t linear_size = 16;
+    size_t low = 0;
+    size_t high = static_cast<size_t>(last - first); // [low, high) contains the lower bound
+    bool interpolate = true;
+    while (high - low > linear_size) {
+      const KeyType& low_key = first[low];
+      const KeyType& high_key = first[high - 1];
+      if (!(low_key < value))
+        return first + low;
+      if (high_key < value)
+        return first + high;
+      size_t probe = low + (high - low) / 2;
+      if (interpolate) {
+        const double fraction = (static_cast<double>(value) - static_cast<double>(low_key)) / (static_cast<double>(high_key) - static_cast<double>(low_key));
+        probe = low + static_cast<size_t>(fraction * static_cast<double>(high - 1 - low));
+        probe = std::min(std::max(probe, low), high - 1);
+      }
+      const size_t size = high - low;
+      if (first[probe] < value)
+        low = probe + 1;
+      else
+        high = probe;
+      interpolate = high - low <= size / 2;
+    }
+    return branchless_lower_bound(first + low, first + high, value, less_than());
+  }
+
+  // gallop_lower_bound_backward - exponential search back from last, cheap when the result is close to last
+  template <typename IteratorType, typename ValueType>
+  IteratorType
+  gallop_lower_bound_backward(IteratorType first, IteratorType last, const ValueType& value) {
+    const auto length = last - first;
+    if (length == 0 || last[-1] < value)
+      return last;
+    const IteratorType back = last - 1;
+    decltype(last - first) bound = 1;
+    while (bound < length && !(back[-bound] < value))
+      bound *= 2;
+    return branchless_lower_bound(bound < length ? back - bound + 1 : first, back - bound / 2, value, less_than());
+  }
+
+  // exponential_lower_bound - gallops from hint towards the lower bound in either direction, O(log d) for a result
+  // d elements away from the hint
+  template <typename IteratorType, typename ValueType>
+  IteratorType
+  exponential_lower_bound(IteratorType first, IteratorType last, IteratorType hint, const ValueType& value) {
+    if (hint != last && *hint < value)
+      return gallop_lower_bound(hint, last, value);
+    return gallop_lower_bound_backward(first, hint, value);
+  }
+  template <typename IteratorType, typename HintType>
+  IteratorType search_hint(IteratorType first, IteratorType last, const HintType& hint, std::true_type) { // index
+    return first + static_cast<ptrdiff_t>(std::min(static_cast<size_t>(hint), static_cast<size_t>(last - first)));
+  }
+  template <typename IteratorType, typename HintType>
+  IteratorType search_hint(IteratorType, IteratorType, const HintType& hint, std::false_type) { // iterator
+    return hint;
+  }
+}
+CREATE_TAG_1_ARG( InterpolationSearchTag );
+template <typename ContainerType, typename ArgType0> // value, returns the lower bound
+typename ContainerType::const_iterator
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::InterpolationSearchTag1Arg<ArgType0>& tag) {
+  UNDERSCORE_STATIC_ASSERT(std::is_rvalue_reference<ContainerType>::value == false, "");
+  return UnderscoreDetail::interpolation_lower_bound(std::begin(container), std::end(container), tag.arg0);
+}
+CREATE_TAG_2_ARG( ExponentialSearchTag );
+template <typename ContainerType, typename ArgType0, typename ArgType1> // value, hint index or iterator, returns the lower bound
+typename ContainerType::const_iterator
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ExponentialSearchTag2Arg<ArgType0, ArgType1>& tag) {
+  UNDERSCORE_STATIC_ASSERT(std::is_rvalue_reference<ContainerType>::value == false, "");
+  typedef typename ContainerType::const_iterator IteratorType;
+  const IteratorType first = std::begin(container);
+  const IteratorType last = std::end(container);
+  const IteratorType hint = UnderscoreDetail::search_hint(first, last, tag.arg1, std::is_integral<ArgType1>());
+  return UnderscoreDetail::exponential_lower_bound(first, last, hint, tag.arg0);
+}
+
+/// parallel_for
+namespace UnderscoreDetail {
+  inline size_t hardware_threads() {
+    const size_t threads = static_cast<size_t>(std::thread::hardware_concurrency());
+    return threads == 0 ? 1 : threads;
+  }
+  // parallel_for - runs task(idx) for every idx in [0, count) on up to hardware_threads() threads, the calling thread included
+  template <typename FunctorType>
+  void parallel_for(size_t count, const FunctorType& task) {
+    const size_t thread_count = std::min(count, hardware_threads());
+    std::atomic<size_t> next(0);
+    const auto& worker = [&]() {
+      for (size_t idx = next++; idx < count; idx = next++)
+        task(idx);
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; ++i)
+      threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+      thread.join();
+  }
+  // parallel_chunks - splits [first, first + size) into at most hardware_threads() chunks of at least min_chunk_size,
+  // chunk idx is [firsts[idx], firsts[idx + 1]) and starts at element offsets[idx]
+  template <typename IteratorType>
+  size_t parallel_chunks(IteratorType first, size_t size, size_t min_chunk_size, std::vector<IteratorType>& firsts, std::vector<size_t>& offsets) {
+    const size_t chunk_count = std::max<size_t>(1, std::min(hardware_threads(), size / min_chunk_size));
+    firsts.assign(chunk_count + 1, first);
+    offsets.assign(chunk_count + 1, 0);
+    for (size_t chunk = 1; chunk <= chunk_count; ++chunk) {
+      offsets[chunk] = size * chunk / chunk_count;
+      firsts[chunk] = firsts[chunk - 1];
+      std::advance(firsts[chunk], offsets[chunk] - offsets[chunk - 1]);
+    }
+    return chunk_count;
+  }
+}
+
+/// inclusive_scan, exclusive_scan, transform_scan, par_inclusive_scan, par_exclusive_scan, par_transform_scan
+namespace UnderscoreDetail {
+  struct scan_identity {
+    template <typename T>
+    const T& operator()(const T& value) const { return value; }
+  };
+  // use_scan_sse2 - plain sums of 32 and 64 bit integers stored contiguously
+  template <typename ContainerType, typename T, typename TransformFunctorType, typename OpType>
+  struct use_scan_sse2 : std::integral_constant<bool,
+    UNDERSCORE_SSE2 && is_contiguous_container<ContainerType>::value && std::is_same<typename ContainerType::value_type, T>::value &&
+    std::is_same<TransformFunctorType, scan_identity>::value && std::is_same<OpType, std::plus<T> >::value &&
+    std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)> {};
+
+  // scan_seeded - writes the running op fold of transform(element) starting from running and returns the total,
+  // exclusive scans write the running value before the element is added
+  template <typename IteratorType, typename T, typename TransformFunctorType, typename OpType>
+  T scan_seeded(IteratorType first, IteratorType last, T* out, T running, bool inclusive, const TransformFunctorType& transform, const OpType& op, std::false_type) {
+    for (; first != last; ++first, ++out) {
+      if (inclusive) {
+        running = op(running, transform(*first));
+        *out = running;
+      }
+      else {
+        *out = running;
+        running = op(running, transform(*first));
+      }
+    }
+    return running;
+  }
+#if UNDERSCORE_SSE2
+  // scan_sse2 - log2(lanes) shifted adds give the prefix sums of a register, the carry is the broadcast last lane.
+  // Exclusive sums are the inclusive ones minus the element, which is exact in wrapping integer arithmetic.
+  inline __m128i scan_sse2_register(__m128i values, std::integral_constant<size_t, 4>) {
+    values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+    return _mm_add_epi32(values, _mm_slli_si128(values, 8));
+  }
+  inline __m128i scan_sse2_register(__m128i values, std::integral_constant<size_t, 8>) { return _mm_add_epi64(values, _mm_slli_si128(values, 8)); }
+  inline __m128i scan_sse2_add(__m128i a, __m128i b, std::integral_constant<size_t, 4>) { return _mm_add_epi32(a, b); }
+  inline __m128i scan_sse2_add(__m128i a, __m128i b, std::integral_constant<size_t, 8>) { return _mm_add_epi64(a, b); }
+  inline __m128i scan_sse2_sub(__m128i a, __m128i b, std::integral_constant<size_t, 4>) { return _mm_sub_epi32(a, b); }
+  inline __m128i scan_sse2_sub(__m128i a, __m128i b, std::integral_constant<size_t, 8>) { return _mm_sub_epi64(a, b); }
+  inline __m128i scan_sse2_broadcast_last(__m128i values, std::integral_constant<size_t, 4>) { return _mm_shuffle_epi32(values, _MM_SHUFFLE(3, 3, 3, 3)); }
+  inline __m128i scan_sse2_broadcast_last(__m128i values, std::integral_constant<size_t, 8>) { return _mm_unpackhi_epi64(values, values); }
+  template <typename T>
+  T scan_sse2(const T* first, size_t size, T* out, T running, bool inclusive) {
+    typedef typename std::make_unsigned<T>::type UnsignedType;
+    typedef std::integral_constant<size_t, sizeof(T)> Width;
+    const size_t lanes = 16 / sizeof(T);
+    const size_t blocks = size - size % lanes;
+    T lanes_of_running[16 / sizeof(T)];
+    std::fill(lanes_of_running, lanes_of_running + lanes, running);
+    __m128i carry = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes_of_running));
+    for (size_t i = 0; i < blocks; i += lanes) {
+      const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i));
+      const __m128i sums = scan_sse2_add(scan_sse2_register(values, Width()), carry, Width());
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), inclusive ? sums : scan_sse2_sub(sums, values, Width()));
+      carry = scan_sse2_broadcast_last(sums, Width());
+    }
+    if (blocks != 0)
+      running = inclusive ? out[blocks - 1] : static_cast<T>(static_cast<UnsignedType>(out[blocks - 1]) + static_cast<UnsignedType>(first[blocks - 1]));
+    for (size_t i = blocks; i < size; ++i) {
+      const T sum = static_cast<T>(static_cast<UnsignedType>(running) + static_cast<UnsignedType>(first[i]));
+      out[i] = inclusive ? sum : running;
+      running = sum;
+    }
+    return running;
+  }
+#endif
+  template <typename IteratorType, typename T, typename TransformFunctorType, typename OpType>
+  T scan_seeded(IteratorType first, IteratorType last, T* out, T running, bool inclusive, const TransformFunctorType& transform, const OpType& op, std::true_type) {
+#if UNDERSCORE_SSE2
+    (void)transform; // identity and plus, which scan_sse2 applies itself
+    (void)op;
+    return first == last ? running : scan_sse2(std::addressof(*first), static_cast<size_t>(last - first), out, running, inclusive);
+#else
+    return scan_seeded(first, last, out, running, inclusive, transform, op, std::false_type());
+#endif
+  }
+  // scan_unseeded - inclusive scan starting from the first element, nothing is written for an empty range
+  template <typename IteratorType, typename T, typename TransformFunctorType, typename OpType, typename UseSse2>
+  T scan_unseeded(IteratorType first, IteratorType last, T* out, const TransformFunctorType& transform, const OpType& op, UseSse2 use_sse2) {
+    if (first == last)
+      return T();
+    if (UseSse2::value)
+      return scan_seeded(first, last, out, T(), true, transform, op, use_sse2);
+    *out = transform(*first);
+    return scan_seeded(std::next(first), last, out + 1, *out, true, transform, op, std::false_type());
+  }
+
+  // scan - serial scan, init is null for inclusive scans
+  template <typename ContainerType, typename T, typename TransformFunctorType, typename OpType>
+  std::vector<T> scan(const ContainerType& container, const T* init, const TransformFunctorType& transform, const OpType& op) {
+    typedef use_scan_sse2<ContainerType, T, TransformFunctorType, OpType> UseSse2;
+    std::vector<T> result(static_cast<size_t>(std::distance(std::begin(container), std::end(container))));
+    if (init != nullptr)
+      scan_seeded(std::begin(container), std::end(container), result.data(), *init, false, transform, op, UseSse2());
+    else
+      scan_unseeded(std::begin(container), std::end(container), result.data(), transform, op, UseSse2());
+    return result;
+  }
+
+  // par_scan - two pass block scan, every chunk is scanned on its own first, then the fold of the preceding chunk
+  // totals is applied to it. The op must be associative.
+  template <typename ContainerType, typename T, typename TransformFunctorType, typename OpType>
+  std::vector<T> par_scan(const ContainerType& container, const T* init, const TransformFunctorType& transform, const OpType& op) {
+    typedef typename ContainerType::const_iterator IteratorType;
+    typedef use_scan_sse2<ContainerType, T, TransformFunctorType, OpType> UseSse2;
+    const size_t size = static_cast<size_t>(std::distance(std::begin(container), std::end(container)));
+    std::vector<IteratorType> chunk_first;
+    std::vector<size_t> chunk_offset;
+    const size_t chunk_count = parallel_chunks(std::begin(container), size, 1 << 15, chunk_first, chunk_offset);
+    if (chunk_count == 1)
+      return scan(container, init, transform, op);
+    std::vector<T> result(size);
+    std::vector<T> totals(chunk_count);
+    parallel_for(chunk_count, [&](size_t chunk) {
+      totals[chunk] = scan_unseeded(chunk_first[chunk], chunk_first[chunk + 1], result.data() + chunk_offset[chunk], transform, op, UseSse2());
+    });
+    std::vector<T> carries(chunk_count);
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+      if (chunk == 0)
+        carries[chunk] = init != nullptr ? *init : T();
+      else if (chunk == 1 && init == nullptr)
+        carries[chunk] = totals[0];
+      else
+        carries[chunk] = op(carries[chunk - 1], totals[chunk - 1]);
+    }
+    parallel_for(chunk_count, [&](size_t chunk) {
+      T* out = result.data() + chunk_offset[chunk];
+      T* out_last = result.data() + chunk_offset[chunk + 1];
+      const T& carry = carries[chunk];
+      if (init == nullptr) {
+        if (chunk != 0)
+          for (; out != out_last; ++out)
+            *out = op(carry, *out);
+        return;
+      }
+      T running = carry;
+      for (; out != out_last; ++out) {
+        const T inclusive = op(carry, *out);
+        *out = running;
+        running = inclusive;
+      }
+    });
+    return result;
+  }
+}
+namespace UnderscoreTags {
+  IMPLEMENTS_1_ARG_TAG( ExclusiveScanTag )
+  IMPLEMENTS_2_ARG_TAG( ExclusiveScanTag )
+  struct ExclusiveScanTag {
+    ExclusiveScanTag() {}
+    ExclusiveScanTag& operator=(const ExclusiveScanTag&);
+    IMPLEMENTS_1_ARG_OPERATOR( ExclusiveScanTag )
+    IMPLEMENTS_2_ARG_OPERATOR( ExclusiveScanTag )
+  };
+  IMPLEMENTS_1_ARG_TAG( ParExclusiveScanTag )
+  IMPLEMENTS_2_ARG_TAG( ParExclusiveScanTag )
+  struct ParExclusiveScanTag {
+    ParExclusiveScanTag() {}
+    ParExclusiveScanTag& operator=(const ParExclusiveScanTag&);
+    IMPLEMENTS_1_ARG_OPERATOR( ParExclusiveScanTag )
+    IMPLEMENTS_2_ARG_OPERATOR( ParExclusiveScanTag )
+  };
+}
+#define CREATE_SCAN_PIPE_IMPLEMENTATIONS( PREFIX, SCAN_FUNCTION ) \
+  CREATE_TAG_0_1_ARG( PREFIX##InclusiveScanTag ); \
+  template <typename ContainerType> \
+  std::vector<typename ContainerType::value_type> \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::PREFIX##InclusiveScanTag&) { \
+    typedef typename ContainerType::value_type ValueType; \
+    return SCAN_FUNCTION(container, static_cast<const ValueType*>(nullptr), UnderscoreDetail::scan_identity(), std::plus<ValueType>()); \
+  } \
+  template <typename ContainerType, typename ArgType0> /* op */ \
+  std::vector<typename ContainerType::value_type> \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::PREFIX##InclusiveScanTag1Arg<ArgType0>& tag) { \
+    typedef typename ContainerType::value_type ValueType; \
+    return SCAN_FUNCTION(container, static_cast<const ValueType*>(nullptr), UnderscoreDetail::scan_identity(), tag.arg0); \
+  } \
+  template <typename ContainerType, typename ArgType0> /* init */ \
+  std::vector<ArgType0> \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::PREFIX##ExclusiveScanTag1Arg<ArgType0>& tag) { \
+    return SCAN_FUNCTION(container, &tag.arg0, UnderscoreDetail::scan_identity(), std::plus<ArgType0>()); \
+  } \
+  template <typename ContainerType, typename ArgType0, typename ArgType1> /* init, op */ \
+  std::vector<ArgType0> \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::PREFIX##ExclusiveScanTag2Arg<ArgType0, ArgType1>& tag) { \
+    return SCAN_FUNCTION(container, &tag.arg0, UnderscoreDetail::scan_identity(), tag.arg1); \
+  } \
+  CREATE_TAG_2_ARG( PREFIX##TransformScanTag ); \
+  template <typename ContainerType, typename ArgType0, typename ArgType1> /* transform functor, op */ \
+  std::vector<typename std::decay<typename std::result_of<ArgType0(typename ContainerType::value_type)>::type>::type> \
+  PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::PREFIX##TransformScanTag2Arg<ArgType0, ArgType1>& tag) { \
+    typedef typename std::decay<typename std::result_of<ArgType0(typename ContainerType::value_type)>::type>::type ResultType; \
+    return SCAN_FUNCTION(container, static_cast<const ResultType*>(nullptr), tag.arg0, tag.arg1); \
+  }
+CREATE_SCAN_PIPE_IMPLEMENTATIONS( , UnderscoreDetail::scan )
+CREATE_SCAN_PIPE_IMPLEMENTATIONS( Par, UnderscoreDetail::par_scan )
+
+/// copy_if, par_copy_if
+namespace UnderscoreDetail {
+  // select_masks - predicate results of the 64 element blocks [first_block, last_block) as bits, returns the selected count
+  template <typename T, typename PredicateType>
+  size_t select_masks(const T* first, size_t size, size_t first_block, size_t last_block, const PredicateType& predicate, uint64_t* masks) {
+    size_t count = 0;
+    for (size_t block = first_block; block < last_block; ++block) {
+      const T* values = first + block * 64;
+      const size_t values_size = std::min<size_t>(64, size - block * 64);
+      uint64_t mask = 0;
+      for (size_t i = 0; i < values_size; ++i)
+        mask |= static_cast<uint64_t>(predicate(values[i]) ? 1 : 0) << i;
+      masks[block] = mask;
+      count += count_set_bits(mask);
+    }
+    return count;
+  }
+  template <typename T, typename OutputIteratorType>
+  OutputIteratorType compact_masked(const T* first, size_t first_block, size_t last_block, const uint64_t* masks, OutputIteratorType out) {
+    for (size_t block = first_block; block < last_block; ++block)
+      for (uint64_t mask = masks[block]; mask != 0; mask &= mask - 1)
+        *out++ = first[block * 64 + count_trailing_zeros(mask)];
+    return out;
+  }
+  // scatter_masked - every chunk copies into its own part of the output, which needs default constructible
+  // elements to resize into. Other element types are appended by one thread.
+  template <typename T, typename OutContainerType>
+  void scatter_masked(const T* first, const std::vector<size_t>& chunk_block, const std::vector<size_t>& chunk_out, const uint64_t* masks, OutContainerType& out, std::true_type) {
+    out.resize(chunk_out.back());
+    if (out.empty())
+      return;
+    auto* out_first = std::addressof(*out.begin());
+    parallel_for(chunk_block.size() - 1, [&](size_t chunk) {
+      compact_masked(first, chunk_block[chunk], chunk_block[chunk + 1], masks, out_first + chunk_out[chunk]);
+    });
+  }
+  template <typename T, typename OutContainerType>
+  void scatter_masked(const T* first, const std::vector<size_t>& chunk_block, const std::vector<size_t>& chunk_out, const uint64_t* masks, OutContainerType& out, std::false_type) {
+    out.clear();
+    out.reserve(chunk_out.back());
+    compact_masked(first, 0, chunk_block.back(), masks, std::back_inserter(out));
+  }
+
+  // copy_if_compact - stream compaction, the predicate runs once per element into bit masks whose counts give the exact
+  // output size before anything is copied. The parallel version counts per chunk, scans the counts into output
+  // offsets and lets every chunk scatter into its own part of the output.
+  template <typename T, typename PredicateType, typename OutContainerType>
+  void copy_if_compact(const T* first, size_t size, const PredicateType& predicate, OutContainerType& out, bool parallel) {
+    const size_t blocks = (size + 63) / 64;
+    std::vector<uint64_t> masks(blocks);
+    std::vector<uint64_t*> chunk_first;
+    std::vector<size_t> chunk_block;
+    const size_t chunk_count = parallel ? parallel_chunks(masks.data(), blocks, 1 << 10, chunk_first, chunk_block) : 1;
+    if (chunk_count == 1) {
+      const size_t count = select_masks(first, size, 0, blocks, predicate, masks.data());
+      out.clear();
+      out.reserve(count);
+      compact_masked(first, 0, blocks, masks.data(), std::back_inserter(out));
+      return;
+    }
+    std::vector<size_t> chunk_out(chunk_count + 1, 0);
+    parallel_for(chunk_count, [&](size_t chunk) {
+      chunk_out[chunk + 1] = select_masks(first, size, chunk_block[chunk], chunk_block[chunk + 1], predicate, masks.data());
+    });
+    std::partial_sum(chunk_out.begin(), chunk_out.end(), chunk_out.begin());
+    scatter_masked(first, chunk_block, chunk_out, masks.data(), out, std::is_default_constructible<typename OutContainerType::value_type>());
+  }
+  template <typename ContainerType, typename PredicateType, typename OutContainerType>
+  void copy_if_into(const ContainerType& container, const PredicateType& predicate, OutContainerType& out, bool parallel, std::true_type) {
+    const size_t size = static_cast<size_t>(std::distance(std::begin(container), std::end(container)));
+    copy_if_compact(size == 0 ? nullptr : std::addressof(*std::begin(container)), size, predicate, out, parallel);
+  }
+  template <typename ContainerType, typename PredicateType, typename OutContainerType>
+  void copy_if_into(const ContainerType& container, const PredicateType& predicate, OutContainerType& out, bool, std::false_type) {
+    out.clear();
+    std::copy_if(std::begin(container), std::end(container), std::back_inserter(out), predicate);
+  }
+}
+namespace UnderscoreTags {
+  IMPLEMENTS_1_ARG_TAG( CopyIfTag )
+  template <typename PredicateType, typename OutContainerType>
+  struct CopyIfTag2Arg {
+    CopyIfTag2Arg(const PredicateType& arg0, OutContainerType& arg1) : arg0(arg0), arg1(arg1) {}
+    CopyIfTag2Arg& operator=(const CopyIfTag2Arg&);
+    const PredicateType& arg0;
+    OutContainerType& arg1;
+  };
+  struct CopyIfTag {
+    CopyIfTag() {}
+    CopyIfTag& operator=(const CopyIfTag&);
+    IMPLEMENTS_1_ARG_OPERATOR( CopyIfTag )
+    template <typename PredicateType, typename OutContainerType>
+    CopyIfTag2Arg<PredicateType, OutContainerType> operator()(const PredicateType& predicate, OutContainerType& out_container) const {
+      return CopyIfTag2Arg<PredicateType, OutContainerType>(predicate, out_container);
+    }
+  };
+}
+CREATE_TAG_1_ARG( ParCopyIfTag );
+template <typename ContainerType, typename PredicateType>
+std::vector<typename ContainerType::value_type, typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::CopyIfTag1Arg<PredicateType>& tag) {
+  typedef UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type> AllocatorFor;
+  std::vector<typename ContainerType::value_type, typename AllocatorFor::type> output_container(AllocatorFor::get(container));
+  UnderscoreDetail::copy_if_into(container, tag.arg0, output_container, false, UnderscoreDetail::is_contiguous_container<ContainerType>());
+  return output_container;
+}
+template <typename ContainerType, typename PredicateType>
+std::vector<typename ContainerType::value_type, typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ParCopyIfTag1Arg<PredicateType>& tag) {
+  typedef UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type> AllocatorFor;
+  std::vector<typename ContainerType::value_type, typename AllocatorFor::type> output_container(AllocatorFor::get(container));
+  UnderscoreDetail::copy_if_into(container, tag.arg0, output_container, true, UnderscoreDetail::is_contiguous_container<ContainerType>());
+  return output_container;
+}
+template <typename ContainerType, typename PredicateType, typename OutContainerType> // predicate, container whose storage is reused
+typename std::decay<OutContainerType>::type
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::CopyIfTag2Arg<PredicateType, OutContainerType>& tag) {
+  typedef std::integral_constant<bool,
+    UnderscoreDetail::is_contiguous_container<ContainerType>::value && UnderscoreDetail::is_contiguous_container<OutContainerType>::value &&
+    std::is_same<typename ContainerType::value_type, typename OutContainerType::value_type>::value> UseCompaction;
+  const auto& predicate = tag.arg0;
+  auto output_container = std::move(tag.arg1);
+  if (UseCompaction::value) {
+    UnderscoreDetail::copy_if_into(container, predicate, output_container, false, UseCompaction());
+    return output_container;
+  }
+  // Copy allocated part
+  auto input_iterator = std::begin(container);
+  const auto& input_end = std::end(container);
+  auto output_iterator = output_container.begin();
+  size_t output_size = 0;
+  for(; input_iterator != input_end && output_iterator != output_container.end(); ++input_iterator) {
+    if (predicate(*input_iterator)) {
+      (*output_iterator) = (*input_iterator);
+      ++output_iterator;
+      ++output_size;
+    }
+  }
+  // Push back the rest
+  for (; input_iterator != input_end; ++input_iterator) {
+    if (predicate(*input_iterator)) {
+      output_container.push_back(*input_iterator);
+      ++output_size;
+    }
+  }
+  // Erase slack if needed
+  output_container.erase(std::next(output_container.begin(), static_cast<ptrdiff_t>(output_size)), output_container.end());
+  return output_container;
+}
+
+/// transform_into, transform_inplace, par_transform, par_transform_into, par_transform_inplace
+namespace UnderscoreDetail {
+  // par_transform - std::transform over one chunk per thread, the output must hold size elements. Every call
+  // allocates its chunk bounds and starts its threads, only the serial transform_into reuses everything.
+  // Bool outputs are refused by the pipes, std::vector<bool> packs neighbouring elements into shared words.
+  template <typename InputIteratorType, typename OutputIteratorType, typename FunctorType>
+  void par_transform(InputIteratorType first, size_t size, OutputIteratorType out, const FunctorType& functor) {
+    std::vector<InputIteratorType> chunk_first;
+    std::vector<size_t> chunk_offset;
+    const size_t chunk_count = parallel_chunks(first, size, 1 << 14, chunk_first, chunk_offset);
+    parallel_for(chunk_count, [&](size_t chunk) {
+      std::transform(chunk_first[chunk], chunk_first[chunk + 1], std::next(out, static_cast<ptrdiff_t>(chunk_offset[chunk])), functor);
+    });
+  }
+  // transform_into - resizes out to the input size, which does not allocate when its capacity suffices, and writes into it
+  template <typename ContainerType, typename FunctorType, typename OutContainerType>
+  void transform_into(const ContainerType& container, const FunctorType& functor, OutContainerType& out, bool parallel) {
+    const size_t size = static_cast<size_t>(std::distance(std::begin(container), std::end(container)));
+    out.resize(size);
+    if (parallel)
+      par_transform(std::begin(container), size, std::begin(out), functor);
+    else
+      std::transform(std::begin(container), std::end(container), std::begin(out), functor);
+  }
+  template <typename ContainerType, typename FunctorType>
+  void transform_inplace(ContainerType& container, const FunctorType& functor, bool parallel) {
+    typedef typename std::decay<typename std::result_of<FunctorType(typename ContainerType::value_type)>::type>::type ResultType;
+    UNDERSCORE_STATIC_ASSERT((std::is_same<ResultType, typename ContainerType::value_type>::value), "transform_inplace needs a functor returning the value type");
+    if (parallel)
+      par_transform(std::begin(container), static_cast<size_t>(std::distance(std::begin(container), std::end(container))), std::begin(container), functor);
+    else
+      std::transform(std::begin(container), std::end(container), std::begin(container), functor);
+  }
+}
+namespace UnderscoreTags {
+  template <typename FunctorType, typename OutContainerType>
+  struct TransformIntoTag2Arg {
+    TransformIntoTag2Arg(const FunctorType& arg0, OutContainerType& arg1) : arg0(arg0), arg1(arg1) {}
+    TransformIntoTag2Arg& operator=(const TransformIntoTag2Arg&);
+    const FunctorType& arg0;
+    OutContainerType& arg1;
+  };
+  struct TransformIntoTag {
+    TransformIntoTag() {}
+    TransformIntoTag& operator=(const TransformIntoTag&);
+    template <typename FunctorType, typename OutContainerType>
+    TransformIntoTag2Arg<FunctorType, OutContainerType> operator()(const FunctorType& functor, OutContainerType& out_container) const {
+      return TransformIntoTag2Arg<FunctorType, OutContainerType>(functor, out_container);
+    }
+  };
+  template <typename FunctorType, typename OutContainerType>
+  struct ParTransformIntoTag2Arg {
+    ParTransformIntoTag2Arg(const FunctorType& arg0, OutContainerType& arg1) : arg0(arg0), arg1(arg1) {}
+    ParTransformIntoTag2Arg& operator=(const ParTransformIntoTag2Arg&);
+    const FunctorType& arg0;
+    OutContainerType& arg1;
+  };
+  struct ParTransformIntoTag {
+    ParTransformIntoTag() {}
+    ParTransformIntoTag& operator=(const ParTransformIntoTag&);
+    template <typename FunctorType, typename OutContainerType>
+    ParTransformIntoTag2Arg<FunctorType, OutContainerType> operator()(const FunctorType& functor, OutContainerType& out_container) const {
+      return ParTransformIntoTag2Arg<FunctorType, OutContainerType>(functor, out_container);
+    }
+  };
+}
+template <typename ContainerType, typename FunctorType, typename OutContainerType> // functor, container written to
+UnderscoreDetail::mutable_container_base<OutContainerType>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TransformIntoTag2Arg<FunctorType, OutContainerType>& tag) {
+  UnderscoreDetail::transform_into(container, tag.arg0, tag.arg1, false);
+  return UnderscoreDetail::mutable_container_base<OutContainerType>(std::addressof(tag.arg1));
+}
+template <typename ContainerType, typename FunctorType, typename OutContainerType> // functor, container written to
+UnderscoreDetail::mutable_container_base<OutContainerType>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ParTransformIntoTag2Arg<FunctorType, OutContainerType>& tag) {
+  UNDERSCORE_STATIC_ASSERT(!std::is_same<typename OutContainerType::value_type, bool>::value, "par_transform_into can not write bools from several threads");
+  UnderscoreDetail::transform_into(container, tag.arg0, tag.arg1, true);
+  return UnderscoreDetail::mutable_container_base<OutContainerType>(std::addressof(tag.arg1));
+}
+CREATE_TAG_1_ARG( TransformInplaceTag );
+template <typename ContainerType, typename ArgType0>
+ContainerType
+PIPE_OPERATOR(ContainerType container, const UnderscoreTags::TransformInplaceTag1Arg<ArgType0>& tag) {
+  UnderscoreDetail::transform_inplace(container, tag.arg0, false);
+  return container;
+}
+CREATE_TAG_1_ARG( ParTransformInplaceTag );
+template <typename ContainerType, typename ArgType0>
+ContainerType
+PIPE_OPERATOR(ContainerType container, const UnderscoreTags::ParTransformInplaceTag1Arg<ArgType0>& tag) {
+  UNDERSCORE_STATIC_ASSERT(!std::is_same<typename ContainerType::value_type, bool>::value, "par_transform_inplace can not write bools from several threads");
+  UnderscoreDetail::transform_inplace(container, tag.arg0, true);
+  return container;
+}
+CREATE_TAG_1_ARG( ParTransformTag );
+template <typename ContainerType, typename ArgType0>
+std::vector<typename std::decay<typename std::result_of<ArgType0(typename ContainerType::value_type)>::type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ParTransformTag1Arg<ArgType0>& tag) {
+  typedef typename std::decay<typename std::result_of<ArgType0(typename ContainerType::value_type)>::type>::type ResultType;
+  UNDERSCORE_STATIC_ASSERT(!std::is_same<ResultType, bool>::value, "par_transform can not write bools from several threads, use transform");
+  std::vector<ResultType> result;
+  UnderscoreDetail::transform_into(container, tag.arg0, result, true);
+  return result;
+}
+
+/// merge, merge_all, merge_all_view, par_merge_all
+namespace UnderscoreDetail {
+  // loser_tree - tournament tree over k sorted ranges, each inner node keeps the loser of its match so
+  // replacing the winner only replays the matches on its path to the root, log2(k) comparisons per element
+  template <typename IteratorType>
+  class loser_tree {
+  public:
+    loser_tree() {}
+    template <typename RangeIteratorType>
+    loser_tree(RangeIteratorType first, RangeIteratorType last) {
+      for (; first != last; ++first)
+        add(std::begin(*first), std::end(*first));
+      build();
+    }
+    void add(IteratorType first, IteratorType last) { sources_.push_back(std::make_pair(first, last)); }
+    void build() {
+      const size_t k = sources_.size();
+      tree_.assign(k, k); // k is a sentinel which wins against everything
+      for (size_t i = k; i-- > 0; )
+        replay(i);
+    }
+    bool empty() const { return tree_.empty() || exhausted(tree_[0]); }
+    const IteratorType& top() const { return sources_[tree_[0]].first; }
+    void pop() {
+      const size_t winner = tree_[0];
+      ++sources_[winner].first;
+      replay(winner);
+    }
+    bool operator==(const loser_tree& other) const { return sources_ == other.sources_; }
+  private:
+    bool exhausted(size_t idx) const { return sources_[idx].first == sources_[idx].second; }
+    bool beats(size_t a, size_t b) const { // ties are won by the lower index, the merge is stable
+      const size_t k = sources_.size();
+      if (a == k || b == k)
+        return a == k;
+      if (exhausted(a) || exhausted(b))
+        return !exhausted(a);
+      return *sources_[a].first < *sources_[b].first || (!(*sources_[b].first < *sources_[a].first) && a < b);
+    }
+    void replay(size_t winner) {
+      for (size_t node = (winner + sources_.size()) / 2; node > 0; node /= 2)
+        if (beats(tree_[node], winner))
+          std::swap(winner, tree_[node]);
+      tree_[0] = winner;
+    }
+    std::vector<std::pair<IteratorType, IteratorType> > sources_;
+    std::vector<size_t> tree_;
+  };
+
+  // merge_all_iterator - owns the loser tree so every iterator is an independent pass
+  template <typename IteratorType>
+  class merge_all_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::iterator_traits<IteratorType>::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::iterator_traits<IteratorType>::pointer pointer;
+    typedef typename std::iterator_traits<IteratorType>::reference reference;
+    merge_all_iterator() {}
+    explicit merge_all_iterator(const loser_tree<IteratorType>& tree) : tree_(tree) {}
+    reference operator*() const { return *tree_.top(); }
+    pointer operator->() const { return &*tree_.top(); }
+    merge_all_iterator& operator++() {
+      tree_.pop();
+      return *this;
+    }
+    merge_all_iterator operator++(int) {
+      merge_all_iterator copy = *this;
+      tree_.pop();
+      return copy;
+    }
+    bool operator==(const merge_all_iterator& other) const {
+      if (tree_.empty() || other.tree_.empty())
+        return tree_.empty() == other.tree_.empty();
+      return tree_ == other.tree_;
+    }
+    bool operator!=(const merge_all_iterator& other) const { return !(*this == other); }
+  private:
+    loser_tree<IteratorType> tree_;
+  };
+
+  // merge_all_view - lazy k-way merge of sorted ranges, refers to the ranges
+  template <typename IteratorType>
+  class merge_all_view {
+  public:
+    typedef merge_all_iterator<IteratorType> iterator;
+    typedef iterator const_iterator;
+    typedef typename iterator::value_type value_type;
+    template <typename RangeIteratorType>
+    merge_all_view(RangeIteratorType first, RangeIteratorType last) : tree_(first, last) {}
+    iterator begin() const { return iterator(tree_); }
+    iterator end() const { return iterator(); }
+    bool empty() const { return tree_.empty(); }
+  private:
+    loser_tree<IteratorType> tree_;
+  };
+
+  template <typename RangeIteratorType, typename OutputIteratorType>
+  OutputIteratorType
+  merge_all(RangeIteratorType first, RangeIteratorType last, OutputIteratorType out) {
+    typedef decltype(std::begin(*first)) IteratorType;
+    loser_tree<IteratorType> tree(first, last);
+    for (; !tree.empty(); tree.pop())
+      *out++ = *tree.top();
+    return out;
+  }
+
+  // par_merge_all - splits all ranges at common splitter values sampled from the input,
+  // the parts are merged independently into their final place in the output
+  template <typename ContainerType, typename OutputContainerType>
+  void
+  par_merge_all(const ContainerType& ranges, OutputContainerType& out) {
+    typedef decltype(std::begin(*std::begin(ranges))) IteratorType;
+    typedef typename std::iterator_traits<IteratorType>::value_type ValueType;
+    const size_t range_count = static_cast<size_t>(std::distance(std::begin(ranges), std::end(ranges)));
+    size_t total_size = 0;
+    for (auto it = std::begin(ranges); it != std::end(ranges); ++it)
+      total_size += static_cast<size_t>(std::distance(std::begin(*it), std::end(*it)));
+    out.resize(total_size);
+    const size_t part_count = std::min(hardware_threads() * 4, std::max<size_t>(1, total_size / 4096));
+    // Sample every range evenly, the splitters are the quantiles of the samples
+    std::vector<ValueType> samples;
+    for (auto it = std::begin(ranges); it != std::end(ranges); ++it) {
+      const auto size = std::distance(std::begin(*it), std::end(*it));
+      for (size_t i = 1; i < part_count && size > 0; ++i)
+        samples.push_back(*std::next(std::begin(*it), static_cast<ptrdiff_t>(i * static_cast<size_t>(size) / part_count)));
+    }
+    std::sort(samples.begin(), samples.end());
+    std::vector<ValueType> splitters;
+    for (size_t i = 1; i < part_count && !samples.empty(); ++i)
+      splitters.push_back(samples[i * samples.size() / part_count]);
+    // bounds[part][range] is where the range is cut, offsets[part] where the part is written
+    const size_t parts = splitters.size() + 1;
+    std::vector<std::vector<IteratorType> > bounds(parts + 1);
+    std::vector<size_t> offsets(parts + 1, 0);
+    for (auto it = std::begin(ranges); it != std::end(ranges); ++it) {
+      bounds[0].push_back(std::begin(*it));
+      for (size_t part = 1; part < parts; ++part)
+        bounds[part].push_back(std::lower_bound(bounds[part - 1].back(), std::end(*it), splitters[part - 1]));
+      bounds[parts].push_back(std::end(*it));
+      for (size_t part = 1; part <= parts; ++part)
+        offsets[part] += static_cast<size_t>(std::distance(bounds[part - 1].back(), bounds[part].back()));
+    }
+    for (size_t part = 1; part <= parts; ++part)
+      offsets[part] += offsets[part - 1];
+    parallel_for(parts, [&](size_t part) {
+      loser_tree<IteratorType> tree;
+      for (size_t range = 0; range < range_count; ++range)
+        tree.add(bounds[part][range], bounds[part + 1][range]);
+      tree.build();
+      auto dst = std::next(std::begin(out), static_cast<ptrdiff_t>(offsets[part]));
+      for (; !tree.empty(); tree.pop())
+        *dst++ = *tree.top();
+    });
+  }
+}
+CREATE_TAG_1_ARG( MergeTag );
+template <typename ContainerType, typename ArgType0>
+std::vector<typename ContainerType::value_type, typename UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::MergeTag1Arg<ArgType0>& tag) {
+  typedef UnderscoreDetail::allocator_for<ContainerType, typename ContainerType::value_type> AllocatorFor;
+  std::vector<typename ContainerType::value_type, typename AllocatorFor::type> result(AllocatorFor::get(container));
+  result.reserve(static_cast<size_t>(std::distance(std::begin(container), std::end(container)) + std::distance(std::begin(tag.arg0), std::end(tag.arg0))));
+  std::merge(std::begin(container), std::end(container), std::begin(tag.arg0), std::end(tag.arg0), std::back_inserter(result));
+  return result;
+}
+CREATE_TAG_0_ARG( MergeAllTag );
+template <typename ContainerType> // container of sorted containers
+std::vector<typename ContainerType::value_type::value_type>
+PIPE_OPERATOR(const ContainerType& ranges, const UnderscoreTags::MergeAllTag&) {
+  std::vector<typename ContainerType::value_type::value_type> result;
+  size_t total_size = 0;
+  for (auto it = std::begin(ranges); it != std::end(ranges); ++it)
+    total_size += static_cast<size_t>(std::distance(std::begin(*it), std::end(*it)));
+  result.reserve(total_size);
+  UnderscoreDetail::merge_all(std::begin(ranges), std::end(ranges), std::back_inserter(result));
+  return result;
+}
+CREATE_TAG_0_ARG( MergeAllViewTag );
+template <typename ContainerType>
+UnderscoreDetail::merge_all_view<typename ContainerType::value_type::const_iterator>
+PIPE_OPERATOR(const ContainerType& ranges, const UnderscoreTags::MergeAllViewTag&) {
+  return UnderscoreDetail::merge_all_view<typename ContainerType::value_type::const_iterator>(std::begin(ranges), std::end(ranges));
+}
+CREATE_TAG_0_ARG( ParMergeAllTag );
+template <typename ContainerType>
+std::vector<typename ContainerType::value_type::value_type>
+PIPE_OPERATOR(const ContainerType& ranges, const UnderscoreTags::ParMergeAllTag&) {
+  std::vector<typename ContainerType::value_type::value_type> result;
+  UnderscoreDetail::par_merge_all(ranges, result);
+  return result;
+}
+
+
+/// group_by, aggregate_by, par_aggregate_by
+namespace UnderscoreDetail {
+  template <typename ContainerType, typename KeyFunctorType>
+  struct group_key {
+    typedef typename std::decay<typename std::result_of<KeyFunctorType(typename ContainerType::value_type)>::type>::type type;
+  };
+  // keys_are_sorted - adjacent keys never decrease, such input is aggregated in one streaming pass
+  template <typename IteratorType, typename KeyFunctorType>
+  bool keys_are_sorted(IteratorType first, IteratorType last, const KeyFunctorType& key_functor) {
+    if (first == last)
+      return true;
+    auto previous = key_functor(*first);
+    for (++first; first != last; ++first) {
+      auto current = key_functor(*first);
+      if (current < previous)
+        return false;
+      previous = std::move(current);
+    }
+    return true;
+  }
+  template <typename KeyType, typename AccumulatorType, typename IteratorType, typename KeyFunctorType, typename ReducerType>
+  std::vector<std::pair<KeyType, AccumulatorType> > aggregate_sorted(IteratorType first, IteratorType last, const KeyFunctorType& key_functor, const AccumulatorType& init, const ReducerType& reducer) {
+    std::vector<std::pair<KeyType, AccumulatorType> > groups;
+    for (; first != last; ++first) {
+      KeyType key = key_functor(*first);
+      if (groups.empty() || groups.back().first < key)
+        groups.emplace_back(std::move(key), init);
+      groups.back().second = reducer(groups.back().second, *first);
+    }
+    return groups;
+  }
+  template <typename KeyType, typename AccumulatorType, typename IteratorType, typename KeyFunctorType, typename ReducerType>
+  hash_map<KeyType, AccumulatorType> aggregate_hashed(IteratorType first, IteratorType last, const KeyFunctorType& key_functor, const AccumulatorType& init, const ReducerType& reducer) {
+    hash_map<KeyType, AccumulatorType> groups;
+    for (; first != last; ++first) {
+      auto& accumulator = groups.try_emplace(key_functor(*first), init).first->second;
+      accumulator = reducer(accumulator, *first);
+    }
+    return groups;
+  }
+  template <typename KeyType, typename AccumulatorType>
+  flat_map<KeyType, AccumulatorType> sorted_groups(hash_map<KeyType, AccumulatorType>& groups) {
+    std::vector<std::pair<KeyType, AccumulatorType> > sorted;
+    sorted.reserve(groups.size());
+    for (auto it = groups.begin(); it != groups.end(); ++it)
+      sorted.emplace_back(it->first, std::move(it->second));
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<KeyType, AccumulatorType>& a, const std::pair<KeyType, AccumulatorType>& b) { return a.first < b.first; });
+    return flat_map<KeyType, AccumulatorType>(sorted_unique_t(), std::move(sorted));
+  }
+}
+CREATE_TAG_1_ARG( GroupByTag );
+template <typename ContainerType, typename KeyFunctorType> // key functor, the elements of a group keep their order
+UnderscoreDetail::hash_map<typename UnderscoreDetail::group_key<ContainerType, KeyFunctorType>::type, std::vector<typename ContainerType::value_type> >
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::GroupByTag1Arg<KeyFunctorType>& tag) {
+  typedef typename UnderscoreDetail::group_key<ContainerType, KeyFunctorType>::type KeyType;
+  UnderscoreDetail::hash_map<KeyType, std::vector<typename ContainerType::value_type> > groups;
+  for (auto it = std::begin(container); it != std::end(container); ++it)
+    groups[tag.arg0(*it)].push_back(*it);
+  return groups;
+}
+CREATE_TAG_3_ARG( AggregateByTag );
+template <typename ContainerType, typename KeyFunctorType, typename AccumulatorType, typename ReducerType> // key functor, initial value, reducer(accumulator, element)
+UnderscoreDetail::flat_map<typename UnderscoreDetail::group_key<ContainerType, KeyFunctorType>::type, AccumulatorType>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::AggregateByTag3Arg<KeyFunctorType, AccumulatorType, ReducerType>& tag) {
+  typedef typename UnderscoreDetail::group_key<ContainerType, KeyFunctorType>::type KeyType;
+  if (UnderscoreDetail::keys_are_sorted(std::begin(container), std::end(container), tag.arg0)) {
+    return UnderscoreDetail::flat_map<KeyType, AccumulatorType>(UnderscoreDetail::sorted_unique_t(),
+      UnderscoreDetail::aggregate_sorted<KeyType>(std::begin(container), std::end(container), tag.arg0, tag.arg1, tag.arg2));
+  }
+  auto groups = UnderscoreDetail::aggregate_hashed<KeyType>(std::begin(container), std::end(container), tag.arg0, tag.arg1, tag.arg2);
+  return UnderscoreDetail::sorted_groups(groups);
+}
+CREATE_TAG_4_ARG( ParAggregateByTag );
+template <typename ContainerType, typename KeyFunctorType, typename AccumulatorType, typename ReducerType, typename CombinerType> // key functor, initial value, reducer, combiner(accumulator, accumulator)
+UnderscoreDetail::flat_map<typename UnderscoreDetail::group_key<ContainerType, KeyFunctorType>::type, AccumulatorType>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ParAggregateByTag4Arg<KeyFunctorType, AccumulatorType, ReducerType, CombinerType>& tag) {
+  typedef typename UnderscoreDetail::group_key<ContainerType, KeyFunctorType>::type KeyType;
+  typedef UnderscoreDetail::hash_map<KeyType, AccumulatorType> TableType;
+  // every thread aggregates its own slice into a private table, the tables are combined afterwards
+  const size_t size = container.size();
+  const size_t slice_count = std::max<size_t>(1, std::min(UnderscoreDetail::hardware_threads(), size / 4096));
+  std::vector<TableType> partials(slice_count);
+  UnderscoreDetail::parallel_for(slice_count, [&](size_t slice) {
+    const auto& first = std::next(std::begin(container), static_cast<ptrdiff_t>(size * slice / slice_count));
+    const auto& last = std::next(std::begin(container), static_cast<ptrdiff_t>(size * (slice + 1) / slice_count));
+    partials[slice] = UnderscoreDetail::aggregate_hashed<KeyType>(first, last, tag.arg0, tag.arg1, tag.arg2);
+  });
+  TableType& groups = partials.front();
+  for (size_t slice = 1; slice < slice_count; ++slice) {
+    for (auto it = partials[slice].begin(); it != partials[slice].end(); ++it) {
+      const auto& result = groups.try_emplace(it->first, it->second);
+      if (!result.second)
+        result.first->second = tag.arg3(result.first->second, it->second);
+    }
+  }
+  return UnderscoreDetail::sorted_groups(groups);
+}
+
+/// hash_join, merge_join
+namespace UnderscoreDetail {
+  // join_kind - inner pairs every match, left_outer also keeps unmatched left elements paired with nullptr,
+  // semi keeps each left element with a match once and anti keeps each left element without one
+  enum class join_kind { inner, left_outer, semi, anti };
+  const size_t join_npos = static_cast<size_t>(-1);
+
+  // hash_join_state - the build side chained per key in a hash_map, built in reverse so each chain is in input order.
+  // Inner joins build on the smaller input, the other kinds always build on the right.
+  template <typename LeftType, typename RightType, typename KeyType>
+  struct hash_join_state {
+    template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType>
+    hash_join_state(const LeftContainerType& left, const RightContainerType& right, const LeftKeyFunctorType& left_key, const RightKeyFunctorType& right_key, join_kind kind)
+    : kind(kind) {
+      for (auto it = std::begin(left); it != std::end(left); ++it)
+        left_rows.push_back(std::addressof(*it));
+      for (auto it = std::begin(right); it != std::end(right); ++it)
+        right_rows.push_back(std::addressof(*it));
+      build_left = kind == join_kind::inner && left_rows.size() < right_rows.size();
+      const size_t build_count = build_left ? left_rows.size() : right_rows.size();
+      next.assign(build_count, join_npos);
+      heads.reserve(build_count);
+      for (size_t row = build_count; row-- > 0;) {
+        const auto& inserted = build_left ? heads.try_emplace(left_key(*left_rows[row]), row) : heads.try_emplace(right_key(*right_rows[row]), row);
+        if (!inserted.second) {
+          next[row] = inserted.first->second;
+          inserted.first->second = row;
+        }
+      }
+      probe_keys.reserve(build_left ? right_rows.size() : left_rows.size());
+      if (build_left) {
+        for (size_t row = 0; row < right_rows.size(); ++row)
+          probe_keys.push_back(head_of(right_key(*right_rows[row])));
+      }
+      else {
+        for (size_t row = 0; row < left_rows.size(); ++row)
+          probe_keys.push_back(head_of(left_key(*left_rows[row])));
+      }
+    }
+    template <typename ProbeKeyType>
+    size_t head_of(const ProbeKeyType& key) const {
+      const auto& it = heads.find(key);
+      return it == heads.end() ? join_npos : it->second;
+    }
+    join_kind kind;
+    bool build_left;
+    std::vector<const LeftType*> left_rows;
+    std::vector<const RightType*> right_rows;
+    hash_map<KeyType, size_t> heads;
+    std::vector<size_t> next;
+    std::vector<size_t> probe_keys; // the first build row matching each probe row
+  };
+  template <typename LeftType, typename RightType, typename KeyType>
+  class hash_join_iterator {
+    typedef hash_join_state<LeftType, RightType, KeyType> state_type;
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef std::pair<const LeftType*, const RightType*> value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+    hash_join_iterator() : state_(nullptr), probe_(0), match_(join_npos) {}
+    hash_join_iterator(const state_type* state, size_t probe) : state_(state), probe_(probe), match_(join_npos) {
+      settle();
+    }
+    reference operator*() const { return row_; }
+    pointer operator->() const { return &row_; }
+    hash_join_iterator& operator++() {
+      const bool pairs_every_match = state_->kind == join_kind::inner || state_->kind == join_kind::left_outer;
+      if (pairs_every_match && match_ != join_npos && state_->next[match_] != join_npos) {
+        match_ = state_->next[match_];
+        update_row();
+        return *this;
+      }
+      ++probe_;
+      settle();
+      return *this;
+    }
+    hash_join_iterator operator++(int) {
+      hash_join_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+    bool operator==(const hash_join_iterator& other) const { return probe_ == other.probe_ && match_ == other.match_; }
+    bool operator!=(const hash_join_iterator& other) const { return !(*this == other); }
+  private:
+    void settle() {
+      for (; probe_ < state_->probe_keys.size(); ++probe_) {
+        match_ = state_->probe_keys[probe_];
+        const bool matched = match_ != join_npos;
+        if (state_->kind == join_kind::left_outer || matched == (state_->kind != join_kind::anti)) {
+          update_row();
+          return;
+        }
+      }
+      match_ = join_npos;
+    }
+    void update_row() {
+      if (state_->build_left)
+        row_ = value_type(state_->left_rows[match_], state_->right_rows[probe_]);
+      else
+        row_ = value_type(state_->left_rows[probe_], match_ == join_npos || state_->kind == join_kind::anti ? nullptr : state_->right_rows[match_]);
+    }
+    const state_type* state_;
+    size_t probe_;
+    size_t match_;
+    value_type row_;
+  };
+  template <typename LeftType, typename RightType, typename KeyType>
+  class hash_join_view {
+    typedef hash_join_state<LeftType, RightType, KeyType> state_type;
+  public:
+    typedef hash_join_iterator<LeftType, RightType, KeyType> iterator;
+    typedef iterator const_iterator;
+    typedef typename iterator::value_type value_type;
+    explicit hash_join_view(const std::shared_ptr<const state_type>& state) : state_(state) {}
+    iterator begin() const { return iterator(state_.get(), 0); }
+    iterator end() const { return iterator(state_.get(), state_->probe_keys.size()); }
+    bool empty() const { return begin() == end(); }
+  private:
+    std::shared_ptr<const state_type> state_;
+  };
+
+  // merge_join_iterator - both inputs sorted by key, every left element finds its run of equal right keys
+  // by moving forward, so the join is one pass over each input
+  template <typename LeftIterator, typename RightIterator, typename LeftKeyFunctorType, typename RightKeyFunctorType>
+  class merge_join_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef std::pair<const typename std::iterator_traits<LeftIterator>::value_type*, const typename std::iterator_traits<RightIterator>::value_type*> value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+    merge_join_iterator(LeftIterator left, LeftIterator left_last, RightIterator right, RightIterator right_last, const LeftKeyFunctorType& left_key, const RightKeyFunctorType& right_key, join_kind kind)
+    : left_(left), left_last_(left_last), run_first_(right), run_last_(right), match_(right), right_last_(right_last)
+    , left_key_(left_key), right_key_(right_key), kind_(kind), run_valid_(false) {
+      settle();
+    }
+    reference operator*() const { return row_; }
+    pointer operator->() const { return &row_; }
+    merge_join_iterator& operator++() {
+      const bool pairs_every_match = kind_ == join_kind::inner || kind_ == join_kind::left_outer;
+      if (pairs_every_match && match_ != run_last_ && ++match_ != run_last_) {
+        row_.second = std::addressof(*match_);
+        return *this;
+      }
+      ++left_;
+      settle();
+      return *this;
+    }
+    merge_join_iterator operator++(int) {
+      merge_join_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+    bool operator==(const merge_join_iterator& other) const { return left_ == other.left_ && (left_ == left_last_ || match_ == other.match_); }
+    bool operator!=(const merge_join_iterator& other) const { return !(*this == other); }
+  private:
+    void settle() {
+      for (; left_ != left_last_; ++left_) {
+        const auto& key = left_key_(*left_);
+        while (run_first_ != right_last_ && right_key_(*run_first_) < key) {
+          ++run_first_;
+          run_valid_ = false;
+        }
+        // A non-empty run stays valid until run_first_ moves past it, an empty one is found again for every key
+        if (!run_valid_ || run_first_ == run_last_) {
+          run_last_ = run_first_;
+          while (run_last_ != right_last_ && !(key < right_key_(*run_last_)))
+            ++run_last_;
+          run_valid_ = true;
+        }
+        match_ = run_first_;
+        const bool matched = run_first_ != run_last_;
+        if (kind_ == join_kind::left_outer || matched == (kind_ != join_kind::anti)) {
+          row_ = value_type(std::addressof(*left_), matched && kind_ != join_kind::anti ? std::addressof(*match_) : nullptr);
+          if (!matched)
+            match_ = run_last_;
+          return;
+        }
+      }
+    }
+    LeftIterator left_;
+    LeftIterator left_last_;
+    RightIterator run_first_;
+    RightIterator run_last_;
+    RightIterator match_;
+    RightIterator right_last_;
+    LeftKeyFunctorType left_key_;
+    RightKeyFunctorType right_key_;
+    join_kind kind_;
+    bool run_valid_;
+    value_type row_;
+  };
+  template <typename LeftIterator, typename RightIterator, typename LeftKeyFunctorType, typename RightKeyFunctorType>
+  class merge_join_view {
+  public:
+    typedef merge_join_iterator<LeftIterator, RightIterator, LeftKeyFunctorType, RightKeyFunctorType> iterator;
+    typedef iterator const_iterator;
+    typedef typename iterator::value_type value_type;
+    merge_join_view(LeftIterator left, LeftIterator left_last, RightIterator right, RightIterator right_last, const LeftKeyFunctorType& left_key, const RightKeyFunctorType& right_key, join_kind kind)
+    : left_(left), left_last_(left_last), right_(right), right_last_(right_last), left_key_(left_key), right_key_(right_key), kind_(kind) {}
+    iterator begin() const { return iterator(left_, left_last_, right_, right_last_, left_key_, right_key_, kind_); }
+    iterator end() const { return iterator(left_last_, left_last_, right_last_, right_last_, left_key_, right_key_, kind_); }
+    bool empty() const { return begin() == end(); }
+  private:
+    LeftIterator left_;
+    LeftIterator left_last_;
+    RightIterator right_;
+    RightIterator right_last_;
+    LeftKeyFunctorType left_key_;
+    RightKeyFunctorType right_key_;
+    join_kind kind_;
+  };
+  template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType>
+  struct hash_join_types {
+    typedef typename LeftContainerType::value_type left_type;
+    typedef typename RightContainerType::value_type right_type;
+    typedef typename std::decay<typename std::result_of<LeftKeyFunctorType(left_type)>::type>::type key_type;
+    typedef hash_join_state<left_type, right_type, key_type> state_type;
+    typedef hash_join_view<left_type, right_type, key_type> view_type;
+  };
+  template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType>
+  typename hash_join_types<LeftContainerType, RightContainerType, LeftKeyFunctorType>::view_type
+  hash_join(const LeftContainerType& left, const RightContainerType& right, const LeftKeyFunctorType& left_key, const RightKeyFunctorType& right_key, join_kind kind) {
+    typedef hash_join_types<LeftContainerType, RightContainerType, LeftKeyFunctorType> types;
+    return typename types::view_type(std::make_shared<const typename types::state_type>(left, right, left_key, right_key, kind));
+  }
+}
+namespace UnderscoreTags {
+  IMPLEMENTS_3_ARG_TAG( HashJoinTag )
+  IMPLEMENTS_4_ARG_TAG( HashJoinTag )
+  struct HashJoinTag {
+    HashJoinTag() {}
+    HashJoinTag& operator=(const HashJoinTag&);
+    IMPLEMENTS_3_ARG_OPERATOR( HashJoinTag )
+    IMPLEMENTS_4_ARG_OPERATOR( HashJoinTag )
+    // the joined rows point into the right container, a temporary would be gone before they are read
+    template <typename ArgType0, typename ArgType1, typename ArgType2>
+    void operator() (const ArgType0&& arg0, const ArgType1& arg1, const ArgType2& arg2) const = delete;
+    template <typename ArgType0, typename ArgType1, typename ArgType2, typename ArgType3>
+    void operator() (const ArgType0&& arg0, const ArgType1& arg1, const ArgType2& arg2, const ArgType3& arg3) const = delete;
+  };
+  IMPLEMENTS_3_ARG_TAG( MergeJoinTag )
+  IMPLEMENTS_4_ARG_TAG( MergeJoinTag )
+  struct MergeJoinTag {
+    MergeJoinTag() {}
+    MergeJoinTag& operator=(const MergeJoinTag&);
+    IMPLEMENTS_3_ARG_OPERATOR( MergeJoinTag )
+    IMPLEMENTS_4_ARG_OPERATOR( MergeJoinTag )
+    // the joined rows point into the right container, a temporary would be gone before they are read
+    template <typename ArgType0, typename ArgType1, typename ArgType2>
+    void operator() (const ArgType0&& arg0, const ArgType1& arg1, const ArgType2& arg2) const = delete;
+    template <typename ArgType0, typename ArgType1, typename ArgType2, typename ArgType3>
+    void operator() (const ArgType0&& arg0, const ArgType1& arg1, const ArgType2& arg2, const ArgType3& arg3) const = delete;
+  };
+}
+// The joins are lazy views of pointers into both inputs, which must outlive them. Temporary inputs are refused.
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType>
+void PIPE_OPERATOR(const LeftContainerType&& left, const UnderscoreTags::HashJoinTag3Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType>& tag) = delete;
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType, typename ArgType3>
+void PIPE_OPERATOR(const LeftContainerType&& left, const UnderscoreTags::HashJoinTag4Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType, ArgType3>& tag) = delete;
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType>
+void PIPE_OPERATOR(const LeftContainerType&& left, const UnderscoreTags::MergeJoinTag3Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType>& tag) = delete;
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType, typename ArgType3>
+void PIPE_OPERATOR(const LeftContainerType&& left, const UnderscoreTags::MergeJoinTag4Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType, ArgType3>& tag) = delete;
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType> // right, left key functor, right key functor
+typename UnderscoreDetail::hash_join_types<LeftContainerType, RightContainerType, LeftKeyFunctorType>::view_type
+PIPE_OPERATOR(const LeftContainerType& left, const UnderscoreTags::HashJoinTag3Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType>& tag) {
+  return UnderscoreDetail::hash_join(left, tag.arg0, tag.arg1, tag.arg2, UnderscoreDetail::join_kind::inner);
+}
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType> // right, left key functor, right key functor, join_kind
+typename UnderscoreDetail::hash_join_types<LeftContainerType, RightContainerType, LeftKeyFunctorType>::view_type
+PIPE_OPERATOR(const LeftContainerType& left, const UnderscoreTags::HashJoinTag4Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType, UnderscoreDetail::join_kind>& tag) {
+  return UnderscoreDetail::hash_join(left, tag.arg0, tag.arg1, tag.arg2, tag.arg3);
+}
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType> // both sorted by key
+UnderscoreDetail::merge_join_view<typename LeftContainerType::const_iterator, typename RightContainerType::const_iterator, LeftKeyFunctorType, RightKeyFunctorType>
+PIPE_OPERATOR(const LeftContainerType& left, const UnderscoreTags::MergeJoinTag3Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType>& tag) {
+  return UnderscoreDetail::merge_join_view<typename LeftContainerType::const_iterator, typename RightContainerType::const_iterator, LeftKeyFunctorType, RightKeyFunctorType>(
+    std::begin(left), std::end(left), std::begin(tag.arg0), std::end(tag.arg0), tag.arg1, tag.arg2, UnderscoreDetail::join_kind::inner);
+}
+template <typename LeftContainerType, typename RightContainerType, typename LeftKeyFunctorType, typename RightKeyFunctorType>
+UnderscoreDetail::merge_join_view<typename LeftContainerType::const_iterator, typename RightContainerType::const_iterator, LeftKeyFunctorType, RightKeyFunctorType>
+PIPE_OPERATOR(const LeftContainerType& left, const UnderscoreTags::MergeJoinTag4Arg<RightContainerType, LeftKeyFunctorType, RightKeyFunctorType, UnderscoreDetail::join_kind>& tag) {
+  return UnderscoreDetail::merge_join_view<typename LeftContainerType::const_iterator, typename RightContainerType::const_iterator, LeftKeyFunctorType, RightKeyFunctorType>(
+    std::begin(left), std::end(left), std::begin(tag.arg0), std::end(tag.arg0), tag.arg1, tag.arg2, tag.arg3);
+}
+
+/// binary_records, external_sort
+namespace UnderscoreDetail {
+  // binary_record_iterator - reads fixed size records from a binary stream, single pass
+  template <typename T>
+  class binary_record_iterator {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+    binary_record_iterator() : stream_(nullptr) {}
+    explicit binary_record_iterator(std::istream& stream) : stream_(&stream) { read(); }
+    reference operator*() const { return value_; }
+    pointer operator->() const { return &value_; }
+    binary_record_iterator& operator++() {
+      read();
+      return *this;
+    }
+    binary_record_iterator operator++(int) {
+      binary_record_iterator copy = *this;
+      read();
+      return copy;
+    }
+    bool operator==(const binary_record_iterator& other) const { return stream_ == other.stream_; }
+    bool operator!=(const binary_record_iterator& other) const { return stream_ != other.stream_; }
+  private:
+    void read() {
+      if (!stream_->read(reinterpret_cast<char*>(&value_), sizeof(T)))
+        stream_ = nullptr;
+    }
+    std::istream* stream_;
+    T value_;
+  };
+  template <typename T>
+  class binary_record_range {
+    UNDERSCORE_STATIC_ASSERT(std::is_trivially_copyable<T>::value, "binary records must be trivially copyable");
+  public:
+    typedef T value_type;
+    typedef binary_record_iterator<T> iterator;
+    typedef binary_record_iterator<T> const_iterator;
+    explicit binary_record_range(std::istream& stream) : stream_(&stream) {}
+    iterator begin() const { return iterator(*stream_); }
+    iterator end() const { return iterator(); }
+  private:
+    std::istream* stream_;
+  };
+  // binary_record_writer - output iterator writing fixed size records to a binary stream
+  template <typename T>
+  class binary_record_writer {
+  public:
+    typedef std::output_iterator_tag iterator_category;
+    typedef void value_type;
+    typedef void difference_type;
+    typedef void pointer;
+    typedef void reference;
+    explicit binary_record_writer(std::ostream& stream) : stream_(&stream) {}
+    binary_record_writer& operator=(const T& value) {
+      stream_->write(reinterpret_cast<const char*>(&value), sizeof(T));
+      return *this;
+    }
+    binary_record_writer& operator*() { return *this; }
+    binary_record_writer& operator++() { return *this; }
+    binary_record_writer& operator++(int) { return *this; }
+  private:
+    std::ostream* stream_;
+  };
+
+  // defined with lz4_compress, runs can be stored as LZ4 blocks
+  inline std::vector<char> lz4_compress(const char* input, size_t size);
+  inline bool lz4_decompress(const char* input, size_t size, std::vector<char>& out);
+
+  enum class run_compression { none, lz4 };
+  // run_block_records - records per LZ4 block of a compressed run, 64KB keeps matches within the LZ4 offset range
+  template <typename T>
+  size_t run_block_records() { return std::max<size_t>(1, (static_cast<size_t>(1) << 16) / sizeof(T)); }
+
+  // run_writer - writes a run file, a compressed run is a sequence of LZ4 blocks of run_block_records
+  // each prefixed by its compressed size
+  template <typename T>
+  class run_writer {
+  public:
+    run_writer(const std::string& path, run_compression compression)
+    : stream_(path.c_str(), std::ios::binary)
+    , compression_(compression)
+    , count_(0) {}
+    void push(const T& value) {
+      buffer_.push_back(value);
+      if (buffer_.size() == run_block_records<T>())
+        flush();
+    }
+    void write(const T* records, size_t count) {
+      count_ += count;
+      if (compression_ == run_compression::none) {
+        stream_.write(reinterpret_cast<const char*>(records), static_cast<std::streamsize>(count * sizeof(T)));
+        return;
+      }
+      for (size_t block = 0; block < count; block += run_block_records<T>()) {
+        const size_t block_count = std::min(count - block, run_block_records<T>());
+        const std::vector<char> compressed = lz4_compress(reinterpret_cast<const char*>(records + block), block_count * sizeof(T));
+        const uint32_t compressed_size = static_cast<uint32_t>(compressed.size());
+        stream_.write(reinterpret_cast<const char*>(&compressed_size), sizeof(compressed_size));
+        stream_.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+      }
+    }
+    // close - false when anything failed to reach the file
+    bool close() {
+      flush();
+      stream_.close();
+      return stream_.good();
+    }
+    size_t count() const { return count_; }
+  private:
+    void flush() {
+      write(buffer_.data(), buffer_.size());
+      buffer_.clear();
+    }
+    std::ofstream stream_;
+    const run_compression compression_;
+    std::vector<T> buffer_;
+    size_t count_;
+  };
+
+  // run_reader - buffered reader of a sorted run file of a known record count, shared by the copies of its iterator.
+  // A compressed run is read one block at a time. A missing, short or corrupt file ends the run early and sets failed().
+  template <typename T>
+  class run_reader {
+  public:
+    run_reader(const std::string& path, size_t records, size_t buffer_records, run_compression compression)
+    : stream_(path.c_str(), std::ios::binary)
+    , compression_(compression)
+    , buffer_(std::max<size_t>(1, std::min(records, compression == run_compression::lz4 ? run_block_records<T>() : buffer_records)))
+    , remaining_(records)
+    , pos_(0)
+    , size_(0)
+    , failed_(!stream_.is_open()) {
+      fill();
+    }
+    bool exhausted() const { return pos_ == size_; }
+    bool failed() const { return failed_; }
+    const T& current() const { return buffer_[pos_]; }
+    void next() {
+      if (++pos_ == size_)
+        fill();
+    }
+  private:
+    void fill() {
+      pos_ = 0;
+      size_ = 0;
+      if (failed_ || remaining_ == 0)
+        return;
+      const size_t wanted = std::min(remaining_, buffer_.size());
+      if (compression_ == run_compression::lz4)
+        size_ = read_block(wanted);
+      else {
+        stream_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(wanted * sizeof(T)));
+        size_ = static_cast<size_t>(stream_.gcount()) / sizeof(T);
+      }
+      remaining_ -= size_;
+      failed_ = size_ != wanted;
+    }
+    size_t read_block(size_t wanted) {
+      uint32_t compressed_size = 0;
+      if (!stream_.read(reinterpret_cast<char*>(&compressed_size), sizeof(compressed_size)))
+        return 0;
+      compressed_.resize(compressed_size);
+      if (!stream_.read(compressed_.data(), static_cast<std::streamsize>(compressed_size)))
+        return 0;
+      raw_.clear();
+      if (!lz4_decompress(compressed_.data(), compressed_.size(), raw_) || raw_.size() != wanted * sizeof(T))
+        return 0;
+      std::memcpy(buffer_.data(), raw_.data(), raw_.size());
+      return wanted;
+    }
+    std::ifstream stream_;
+    const run_compression compression_;
+    std::vector<T> buffer_;
+    std::vector<char> compressed_;
+    std::vector<char> raw_;
+    size_t remaining_;
+    size_t pos_;
+    size_t size_;
+    bool failed_;
+  };
+  template <typename T>
+  class run_iterator {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+    run_iterator() {}
+    explicit run_iterator(const std::shared_ptr<run_reader<T> >& reader) : reader_(reader) {}
+    reference operator*() const { return reader_->current(); }
+    pointer operator->() const { return &reader_->current(); }
+    run_iterator& operator++() {
+      reader_->next();
+      return *this;
+    }
+    bool operator==(const run_iterator& other) const { return at_end() == other.at_end() && (at_end() || reader_ == other.reader_); }
+    bool operator!=(const run_iterator& other) const { return !(*this == other); }
+  private:
+    bool at_end() const { return !reader_ || reader_->exhausted(); }
+    std::shared_ptr<run_reader<T> > reader_;
+  };
+
+  // external_sorter - sorts more records than fits in memory_budget bytes by writing sorted runs
+  // to tmp_dir and merging them with a loser tree, the run files are removed on destruction.
+  // At most merge_fan_in runs are open at once, more runs are first merged into longer runs in extra passes.
+  // A run which can not be written or read back completely sets failed(), the output is then incomplete.
+  template <typename T>
+  class external_sorter {
+    UNDERSCORE_STATIC_ASSERT(std::is_trivially_copyable<T>::value, "external_sort requires trivially copyable records");
+  public:
+    enum { merge_fan_in = 64 };
+    external_sorter(size_t memory_budget, const std::string& tmp_dir, run_compression compression = run_compression::none)
+    : memory_budget_(std::max(memory_budget, sizeof(T)))
+    , tmp_dir_(tmp_dir)
+    , compression_(compression)
+    , token_(std::random_device()())
+    , next_run_(0)
+    , failed_(false) {
+      buffer_.reserve(memory_budget_ / sizeof(T));
+    }
+    ~external_sorter() {
+      for (const auto& path : runs_)
+        std::remove(path.c_str());
+    }
+    void push(const T& value) {
+      buffer_.push_back(value);
+      if (buffer_.size() == buffer_.capacity())
+        flush_run();
+    }
+    template <typename OutputIteratorType>
+    OutputIteratorType finish(OutputIteratorType out) {
+      std::sort(buffer_.begin(), buffer_.end());
+      if (runs_.empty()) // everything fit in memory
+        return std::copy(buffer_.begin(), buffer_.end(), out);
+      if (!buffer_.empty())
+        flush_run();
+      std::vector<T>().swap(buffer_);
+      while (!failed_ && runs_.size() > merge_fan_in)
+        merge_pass();
+      if (failed_)
+        return out;
+      merge_runs(0, runs_.size(), [&](const T& value) { *out++ = value; });
+      return out;
+    }
+    size_t run_count() const { return runs_.size(); }
+    bool failed() const { return failed_; }
+  private:
+    external_sorter(const external_sorter&);
+    external_sorter& operator=(const external_sorter&);
+    std::string run_path() {
+      std::ostringstream path;
+      path << tmp_dir_ << "/underscore_run_" << token_ << "_" << next_run_++ << ".bin";
+      return path.str();
+    }
+    void flush_run() {
+      if (failed_) { // the result is lost already, don't keep writing
+        buffer_.clear();
+        return;
+      }
+      std::sort(buffer_.begin(), buffer_.end());
+      runs_.push_back(run_path());
+      run_writer<T> writer(runs_.back(), compression_);
+      writer.write(buffer_.data(), buffer_.size());
+      failed_ = !writer.close();
+      run_sizes_.push_back(buffer_.size());
+      buffer_.clear();
+    }
+    template <typename SinkType>
+    void merge_runs(size_t first, size_t last, const SinkType& sink) {
+      const size_t buffer_records = memory_budget_ / sizeof(T) / (last - first);
+      std::vector<std::shared_ptr<run_reader<T> > > readers;
+      loser_tree<run_iterator<T> > tree;
+      for (size_t run = first; run < last; ++run) {
+        readers.push_back(std::make_shared<run_reader<T> >(runs_[run], run_sizes_[run], buffer_records, compression_));
+        tree.add(run_iterator<T>(readers.back()), run_iterator<T>());
+      }
+      tree.build();
+      for (; !tree.empty(); tree.pop())
+        sink(*tree.top());
+      for (const auto& reader : readers)
+        failed_ = failed_ || reader->failed();
+    }
+    // merge_pass - merges every merge_fan_in runs into one, a lone trailing run is kept as it is
+    void merge_pass() {
+      std::vector<std::string> runs;
+      std::vector<size_t> run_sizes;
+      size_t first = 0;
+      for (; first < runs_.size() && !failed_; first += merge_fan_in) {
+        const size_t last = std::min<size_t>(first + merge_fan_in, runs_.size());
+        if (last - first == 1) {
+          runs.push_back(runs_[first]);
+          run_sizes.push_back(run_sizes_[first]);
+          continue;
+        }
+        runs.push_back(run_path());
+        run_writer<T> writer(runs.back(), compression_);
+        merge_runs(first, last, [&](const T& value) { writer.push(value); });
+        failed_ = !writer.close() || failed_;
+        run_sizes.push_back(writer.count());
+        for (size_t run = first; run < last; ++run)
+          std::remove(runs_[run].c_str());
+      }
+      runs.insert(runs.end(), runs_.begin() + static_cast<ptrdiff_t>(std::min(first, runs_.size())), runs_.end()); // left for the destructor after a failure
+      runs_.swap(runs);
+      run_sizes_.swap(run_sizes);
+    }
+    const size_t memory_budget_;
+    const std::string tmp_dir_;
+    const run_compression compression_;
+    const unsigned token_;
+    size_t next_run_;
+    std::vector<T> buffer_;
+    std::vector<std::string> runs_;
+    std::vector<size_t> run_sizes_;
+    bool failed_;
+  };
+}
+namespace UnderscoreTags {
+  IMPLEMENTS_2_ARG_TAG( ExternalSortTag )
+  template <typename ArgType0, typename ArgType1>
+  struct ExternalSortTag3Arg {
+    ExternalSortTag3Arg(const ArgType0& arg0, const ArgType1& arg1, UnderscoreDetail::run_compression arg2)
+    : arg0(arg0), arg1(arg1), arg2(arg2) {}
+    ExternalSortTag3Arg& operator=(const ExternalSortTag3Arg&);
+    const ArgType0& arg0;
+    const ArgType1& arg1;
+    const UnderscoreDetail::run_compression arg2;
+  };
+  template <typename ArgType0, typename ArgType1>
+  struct ExternalSortTag4Arg {
+    ExternalSortTag4Arg(const ArgType0& arg0, const ArgType1& arg1, std::ostream& arg2, UnderscoreDetail::run_compression arg3)
+    : arg0(arg0), arg1(arg1), arg2(arg2), arg3(arg3) {}
+    ExternalSortTag4Arg& operator=(const ExternalSortTag4Arg&);
+    const ArgType0& arg0;
+    const ArgType1& arg1;
+    std::ostream& arg2;
+    const UnderscoreDetail::run_compression arg3;
+  };
+  struct ExternalSortTag {
+    ExternalSortTag() {}
+    ExternalSortTag& operator=(const ExternalSortTag&);
+    IMPLEMENTS_2_ARG_OPERATOR( ExternalSortTag )
+    template <typename ArgType0, typename ArgType1>
+    ExternalSortTag3Arg<ArgType0, ArgType1>
+    operator() (const ArgType0& arg0, const ArgType1& arg1, UnderscoreDetail::run_compression arg2) const {
+      return ExternalSortTag3Arg<ArgType0, ArgType1>(arg0, arg1, arg2);
+    }
+    template <typename ArgType0, typename ArgType1>
+    ExternalSortTag4Arg<ArgType0, ArgType1>
+    operator() (const ArgType0& arg0, const ArgType1& arg1, std::ostream& arg2, UnderscoreDetail::run_compression arg3 = UnderscoreDetail::run_compression::none) const {
+      return ExternalSortTag4Arg<ArgType0, ArgType1>(arg0, arg1, arg2, arg3);
+    }
+  };
+}
+namespace UnderscoreDetail {
+  // external_sort - false if a run file failed, count is the number of input records
+  template <typename ContainerType, typename OutputIteratorType>
+  bool external_sort(const ContainerType& container, size_t memory_budget, const std::string& tmp_dir, run_compression compression, OutputIteratorType out, size_t& count) {
+    external_sorter<typename ContainerType::value_type> sorter(memory_budget, tmp_dir, compression);
+    count = 0;
+    for (auto it = std::begin(container); it != std::end(container); ++it, ++count)
+      sorter.push(*it);
+    sorter.finish(out);
+    return !sorter.failed();
+  }
+}
+template <typename ContainerType, typename ArgType0, typename ArgType1> // sorted records in memory, empty if a run file failed
+std::vector<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ExternalSortTag2Arg<ArgType0, ArgType1>& tag) {
+  std::vector<typename ContainerType::value_type> result;
+  size_t count = 0;
+  if (!UnderscoreDetail::external_sort(container, static_cast<size_t>(tag.arg0), tag.arg1, UnderscoreDetail::run_compression::none, std::back_inserter(result), count))
+    result.clear();
+  return result;
+}
+template <typename ContainerType, typename ArgType0, typename ArgType1> // memory budget, tmp_dir, run_compression
+std::vector<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ExternalSortTag3Arg<ArgType0, ArgType1>& tag) {
+  std::vector<typename ContainerType::value_type> result;
+  size_t count = 0;
+  if (!UnderscoreDetail::external_sort(container, static_cast<size_t>(tag.arg0), tag.arg1, tag.arg2, std::back_inserter(result), count))
+    result.clear();
+  return result;
+}
+template <typename ContainerType, typename ArgType0, typename ArgType1> // sorted records written to a binary stream, returns the record count
+size_t                                                                  // or 0 with the stream's failbit set if a run file failed
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ExternalSortTag4Arg<ArgType0, ArgType1>& tag) {
+  typedef typename ContainerType::value_type ValueType;
+  size_t count = 0;
+  if (!UnderscoreDetail::external_sort(container, static_cast<size_t>(tag.arg0), tag.arg1, tag.arg3, UnderscoreDetail::binary_record_writer<ValueType>(tag.arg2), count)) {
+    tag.arg2.setstate(std::ios::failbit);
+    return 0;
+  }
+  return count;
+}
+
+
+/// mmap_file, mmap_file_mut
+namespace UnderscoreDetail {
+  enum class mmap_advice {
+    normal,
+    sequential,
+    random,
+    willneed,
+    hugepage
+  };
+
+  // mapped_file - contiguous range over a memory mapped file, a file which can not be mapped
+  // gives an empty range with is_open() false. Writable mappings are shared with the file.
+  template <typename T, bool Writable>
+  class mapped_file {
+    UNDERSCORE_STATIC_ASSERT(std::is_trivially_copyable<T>::value, "mapped elements must be trivially copyable");
+  public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::conditional<Writable, T&, const T&>::type reference;
+    typedef const T& const_reference;
+    typedef typename std::conditional<Writable, T*, const T*>::type pointer;
+    typedef pointer iterator;
+    typedef const T* const_iterator;
+
+    mapped_file()
+    : address_(nullptr)
+    , bytes_(0)
+    , open_(false)
+    {}
+    mapped_file(const std::string& path, mmap_advice advice)
+    : address_(nullptr)
+    , bytes_(0)
+    , open_(false) {
+      map(path, advice);
+    }
+    mapped_file(mapped_file&& other)
+    : address_(other.address_)
+    , bytes_(other.bytes_)
+    , open_(other.open_) {
+      other.address_ = nullptr;
+      other.bytes_ = 0;
+      other.open_ = false;
+    }
+    mapped_file& operator=(mapped_file&& other) {
+      if (this != &other) {
+        unmap();
+        std::swap(address_, other.address_);
+        std::swap(bytes_, other.bytes_);
+        std::swap(open_, other.open_);
+      }
+      return *this;
+    }
+    ~mapped_file() { unmap(); }
+    bool is_open() const { return open_; }
+    // advise - tells the kernel how the mapping will be read
+    void advise(mmap_advice advice) const {
+#if UNDERSCORE_MMAP && (defined(__unix__) || defined(__APPLE__))
+      if (address_ == nullptr)
+        return;
+      int flag = MADV_NORMAL;
+      if (advice == mmap_advice::sequential)
+        flag = MADV_SEQUENTIAL;
+      else if (advice == mmap_advice::random)
+        flag = MADV_RANDOM;
+      else if (advice == mmap_advice::willneed)
+        flag = MADV_WILLNEED;
+#ifdef MADV_HUGEPAGE
+      else if (advice == mmap_advice::hugepage)
+        flag = MADV_HUGEPAGE;
+#endif
+      ::madvise(address_, bytes_, flag);
+#else
+      (void)advice;
+#endif
+    }
+    // flush - writes modified pages back to the file
+    void flush() const {
+      UNDERSCORE_STATIC_ASSERT(Writable, "flush requires a writable mapping");
+      if (address_ == nullptr)
+        return;
+#if UNDERSCORE_MMAP && defined(_WIN32)
+      ::FlushViewOfFile(address_, bytes_);
+#elif UNDERSCORE_MMAP && (defined(__unix__) || defined(__APPLE__))
+      ::msync(address_, bytes_, MS_SYNC);
+#endif
+    }
+    size_type size() const { return bytes_ / sizeof(T); }
+    bool empty() const { return size() == 0; }
+    pointer data() const { return static_cast<pointer>(address_); }
+    reference operator[](size_type idx) const { return data()[idx]; }
+    reference front() const { return data()[0]; }
+    reference back() const { return data()[size() - 1]; }
+    iterator begin() const { return data(); }
+    iterator end() const { return data() + size(); }
+    const_iterator cbegin() const { return data(); }
+    const_iterator cend() const { return data() + size(); }
+  private:
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+    void map(const std::string& path, mmap_advice advice) {
+#if UNDERSCORE_MMAP && defined(_WIN32)
+      const DWORD flags = advice == mmap_advice::sequential ? FILE_FLAG_SEQUENTIAL_SCAN : advice == mmap_advice::random ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL;
+      const HANDLE file = ::CreateFileA(path.c_str(), Writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+        return;
+      LARGE_INTEGER file_size;
+      if (!::GetFileSizeEx(file, &file_size)) {
+        ::CloseHandle(file);
+        return;
+      }
+      if (file_size.QuadPart == 0)
+        open_ = true;
+      else {
+        const HANDLE mapping = ::CreateFileMappingA(file, nullptr, Writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+          address_ = ::MapViewOfFile(mapping, Writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+          ::CloseHandle(mapping); // the view keeps the mapping alive
+        }
+        if (address_ != nullptr) {
+          bytes_ = static_cast<size_t>(file_size.QuadPart);
+          open_ = true;
+        }
+      }
+      ::CloseHandle(file);
+#elif UNDERSCORE_MMAP && (defined(__unix__) || defined(__APPLE__))
+      const int fd = ::open(path.c_str(), Writable ? O_RDWR : O_RDONLY);
+      if (fd < 0)
+        return;
+      struct stat info;
+      if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return;
+      }
+      if (info.st_size == 0)
+        open_ = true;
+      else {
+        void* address = ::mmap(nullptr, static_cast<size_t>(info.st_size), Writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        if (address != MAP_FAILED) {
+          address_ = address;
+          bytes_ = static_cast<size_t>(info.st_size);
+          open_ = true;
+          advise(advice);
+        }
+      }
+      ::close(fd); // the mapping keeps the file alive
+#else
+      (void)path;
+      (void)advice;
+#endif
+    }
+    void unmap() {
+      if (address_ == nullptr)
+        return;
+#if UNDERSCORE_MMAP && defined(_WIN32)
+      ::UnmapViewOfFile(address_);
+#elif UNDERSCORE_MMAP && (defined(__unix__) || defined(__APPLE__))
+      ::munmap(address_, bytes_);
+#endif
+      address_ = nullptr;
+      bytes_ = 0;
+    }
+    void* address_;
+    size_t bytes_;
+    bool open_;
+  };
+}
+
+
+/// filter_view
+namespace UnderscoreDetail {
+  // filter_view - lazy range of the elements satisfying the predicate. Holds the range by reference
+  // when piped from an l-value and by value when piped from an r-value, such as another view.
+  template <typename RangeType, typename PredicateType>
+  class filter_view {
+    typedef typename std::remove_reference<RangeType>::type range_type;
+    typedef decltype(std::begin(std::declval<const range_type&>())) base_iterator;
+  public:
+    class iterator {
+    public:
+      typedef typename std::conditional<
+        std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<base_iterator>::iterator_category>::value,
+        std::forward_iterator_tag,
+        std::input_iterator_tag>::type iterator_category;
+      typedef typename std::iterator_traits<base_iterator>::value_type value_type;
+      typedef typename std::iterator_traits<base_iterator>::difference_type difference_type;
+      typedef typename std::iterator_traits<base_iterator>::pointer pointer;
+      typedef typename std::iterator_traits<base_iterator>::reference reference;
+      iterator() : predicate_(nullptr) {}
+      iterator(base_iterator pos, base_iterator last, const PredicateType* predicate)
+      : pos_(pos)
+      , last_(last)
+      , predicate_(predicate) {
+        skip();
+      }
+      reference operator*() const { return *pos_; }
+      pointer operator->() const { return &*pos_; }
+      iterator& operator++() {
+        ++pos_;
+        skip();
+        return *this;
+      }
+      iterator operator++(int) {
+        iterator copy = *this;
+        ++*this;
+        return copy;
+      }
+      bool operator==(const iterator& other) const { return pos_ == other.pos_; }
+      bool operator!=(const iterator& other) const { return pos_ != other.pos_; }
+    private:
+      void skip() {
+        while (pos_ != last_ && !(*predicate_)(*pos_))
+          ++pos_;
+      }
+      base_iterator pos_;
+      base_iterator last_;
+      const PredicateType* predicate_;
+    };
+    typedef iterator const_iterator;
+    typedef typename iterator::value_type value_type;
+    filter_view(RangeType range, const PredicateType& predicate)
+    : range_(std::forward<RangeType>(range))
+    , predicate_(predicate)
+    {}
+    iterator begin() const { return iterator(std::begin(range_), std::end(range_), &predicate_); }
+    iterator end() const { return iterator(std::end(range_), std::end(range_), &predicate_); }
+    bool empty() const { return begin() == end(); }
+  private:
+    RangeType range_;
+    PredicateType predicate_;
+  };
+}
+CREATE_TAG_1_ARG( FilterViewTag );
+template <typename RangeType, typename PredicateType>
+UnderscoreDetail::filter_view<RangeType, PredicateType>
+PIPE_OPERATOR(RangeType&& range, const UnderscoreTags::FilterViewTag1Arg<PredicateType>& tag) {
+  return UnderscoreDetail::filter_view<RangeType, PredicateType>(std::forward<RangeType>(range), tag.arg0);
+}
+
+/// lines
+namespace UnderscoreDetail {
+  // string_ref - non-owning view of characters, converts to std::string_view when compiled as C++17
+  class string_ref {
+  public:
+    typedef char value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef const char& reference;
+    typedef const char& const_reference;
+    typedef const char* pointer;
+    typedef const char* const_pointer;
+    typedef const char* iterator;
+    typedef const char* const_iterator;
+    string_ref() : data_(nullptr), size_(0) {}
+    string_ref(const char* data, size_t size) : data_(data), size_(size) {}
+    string_ref(const char* str) : data_(str), size_(std::char_traits<char>::length(str)) {}
+    string_ref(const std::string& str) : data_(str.data()), size_(str.size()) {}
+#if __cplusplus >= 201703L
+    string_ref(std::string_view str) : data_(str.data()), size_(str.size()) {}
+    operator std::string_view() const { return std::string_view(data_, size_); }
+#endif
+    operator std::string() const { return str(); }
+    std::string str() const { return std::string(data_, size_); }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t length() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const char& operator[](size_t idx) const { return data_[idx]; }
+    const char& front() const { return data_[0]; }
+    const char& back() const { return data_[size_ - 1]; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+    string_ref substr(size_t pos, size_t count = static_cast<size_t>(-1)) const { return string_ref(data_ + pos, std::min(count, size_ - pos)); }
+    friend bool operator==(const string_ref& a, const string_ref& b) { return a.size_ == b.size_ && std::char_traits<char>::compare(a.data_, b.data_, a.size_) == 0; }
+    friend bool operator!=(const string_ref& a, const string_ref& b) { return !(a == b); }
+    friend bool operator<(const string_ref& a, const string_ref& b) {
+      const int result = std::char_traits<char>::compare(a.data_, b.data_, std::min(a.size_, b.size_));
+      return result < 0 || (result == 0 && a.size_ < b.size_);
+    }
+    friend std::ostream& operator<<(std::ostream& stream, const string_ref& str) { return stream.write(str.data_, static_cast<std::streamsize>(str.size_)); }
+  private:
+    const char* data_;
+    size_t size_;
+  };
+  template <>
+  struct is_contiguous_container<string_ref> : std::true_type {};
+
+  // line_reader - splits a stream into lines inside one reusable buffer, the buffer only grows
+  // when a single line does not fit. Line endings, \n or \r\n, are not part of the lines.
+  class line_reader {
+  public:
+    line_reader(std::istream& stream, size_t buffer_bytes)
+    : stream_(&stream)
+    , buffer_(std::max<size_t>(buffer_bytes, 64))
+    , begin_(0)
+    , end_(0)
+    , eof_(false)
+    {}
+    line_reader(const std::string& path, size_t buffer_bytes)
+    : file_(new std::ifstream(path.c_str(), std::ios::binary))
+    , stream_(file_.get())
+    , buffer_(std::max<size_t>(buffer_bytes, 64))
+    , begin_(0)
+    , end_(0)
+    , eof_(!file_->is_open())
+    {}
+    bool is_open() const { return !file_ || file_->is_open(); }
+    // next - points line at the next line, which stays valid until the following call
+    bool next(string_ref& line) {
+      for (;;) {
+        const char* first = buffer_.data() + begin_;
+        const size_t available = end_ - begin_;
+        const char* newline = available == 0 ? nullptr : static_cast<const char*>(std::memchr(first, '\n', available));
+        if (newline != nullptr) {
+          line = trim_carriage_return(first, static_cast<size_t>(newline - first));
+          begin_ += static_cast<size_t>(newline - first) + 1;
+          return true;
+        }
+        if (eof_) {
+          if (available == 0)
+            return false;
+          line = trim_carriage_return(first, available);
+          begin_ = end_;
+          return true;
+        }
+        refill();
+      }
+    }
+  private:
+    static string_ref trim_carriage_return(const char* first, size_t size) {
+      return string_ref(first, size > 0 && first[size - 1] == '\r' ? size - 1 : size);
+    }
+    void refill() {
+      if (begin_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+      }
+      if (end_ == buffer_.size())
+        buffer_.resize(buffer_.size() * 2);
+      stream_->read(buffer_.data() + end_, static_cast<std::streamsize>(buffer_.size() - end_));
+      const size_t count = static_cast<size_t>(stream_->gcount());
+      end_ += count;
+      if (count == 0 || !*stream_)
+        eof_ = true;
+    }
+    std::unique_ptr<std::ifstream> file_;
+    std::istream* stream_;
+    std::vector<char> buffer_;
+    size_t begin_;
+    size_t end_;
+    bool eof_;
+  };
+
+  // line_range - single pass range of string_ref lines
+  class line_range {
+  public:
+    class iterator {
+    public:
+      typedef std::input_iterator_tag iterator_category;
+      typedef string_ref value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const string_ref* pointer;
+      typedef const string_ref& reference;
+      iterator() : reader_(nullptr) {}
+      explicit iterator(line_reader* reader) : reader_(reader) { read(); }
+      reference operator*() const { return line_; }
+      pointer operator->() const { return &line_; }
+      iterator& operator++() {
+        read();
+        return *this;
+      }
+      bool operator==(const iterator& other) const { return reader_ == other.reader_; }
+      bool operator!=(const iterator& other) const { return reader_ != other.reader_; }
+    private:
+      void read() {
+        if (!reader_->next(line_))
+          reader_ = nullptr;
+      }
+      line_reader* reader_;
+      string_ref line_;
+    };
+    typedef iterator const_iterator;
+    typedef string_ref value_type;
+    explicit line_range(const std::shared_ptr<line_reader>& reader) : reader_(reader) {}
+    bool is_open() const { return reader_->is_open(); }
+    iterator begin() const { return iterator(reader_.get()); }
+    iterator end() const { return iterator(); }
+  private:
+    std::shared_ptr<line_reader> reader_;
+  };
+}
+
+
+/// async_chunks
+namespace UnderscoreDetail {
+  // async_chunk_reader - reads a file in fixed size chunks on background threads. Up to in_flight
+  // chunks are read ahead concurrently while the consumer works on the current one, a chunk buffer
+  // is reused once the consumer has moved past it.
+  class async_chunk_reader {
+  public:
+    async_chunk_reader(const std::string& path, size_t chunk_bytes, size_t in_flight)
+    : path_(path)
+    , chunk_bytes_(std::max<size_t>(chunk_bytes, 1))
+    , chunk_count_(0)
+    , file_size_(0)
+    , next_chunk_(0)
+    , consumed_(0)
+    , released_(0)
+    , stop_(false)
+    , open_(false)
+#if defined(__unix__) || defined(__APPLE__)
+    , fd_(-1)
+#endif
+    {
+#if defined(__unix__) || defined(__APPLE__)
+      fd_ = ::open(path.c_str(), O_RDONLY);
+      struct stat info;
+      if (fd_ < 0 || ::fstat(fd_, &info) != 0)
+        return;
+      file_size_ = static_cast<uint64_t>(info.st_size);
+#else
+      std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+      if (!file.is_open())
+        return;
+      file_size_ = static_cast<uint64_t>(file.tellg());
+#endif
+      open_ = true;
+      chunk_count_ = static_cast<size_t>((file_size_ + chunk_bytes_ - 1) / chunk_bytes_);
+      slots_.resize(std::max<size_t>(in_flight, 2));
+      const size_t thread_count = std::min(slots_.size(), chunk_count_);
+      for (size_t i = 0; i < thread_count; ++i)
+        threads_.emplace_back(&async_chunk_reader::work, this);
+    }
+    ~async_chunk_reader() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      changed_.notify_all();
+      for (auto& thread : threads_)
+        thread.join();
+#if defined(__unix__) || defined(__APPLE__)
+      if (fd_ >= 0)
+        ::close(fd_);
+#endif
+    }
+    bool is_open() const { return open_; }
+    uint64_t file_size() const { return file_size_; }
+    // next - hands the previous chunk back for reuse and waits for the following one
+    bool next(string_ref& chunk) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (released_ < consumed_) {
+        released_ = consumed_;
+        changed_.notify_all();
+      }
+      if (consumed_ == chunk_count_)
+        return false;
+      const slot& current = slots_[consumed_ % slots_.size()];
+      const size_t expected = consumed_;
+      changed_.wait(lock, [&]() { return current.chunk == expected; });
+      chunk = string_ref(current.buffer.data(), current.size);
+      ++consumed_;
+      return true;
+    }
+  private:
+    async_chunk_reader(const async_chunk_reader&);
+    async_chunk_reader& operator=(const async_chunk_reader&);
+    struct slot {
+      slot() : chunk(static_cast<size_t>(-1)), size(0) {}
+      std::vector<char> buffer;
+      size_t chunk; // the chunk held by the buffer once it is read
+      size_t size;
+    };
+    void work() {
+#if !defined(__unix__) && !defined(__APPLE__)
+      std::ifstream file(path_.c_str(), std::ios::binary);
+#endif
+      for (;;) {
+        size_t chunk = 0;
+        slot* target = nullptr;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          if (stop_ || next_chunk_ == chunk_count_)
+            return;
+          chunk = next_chunk_++;
+          changed_.wait(lock, [&]() { return stop_ || chunk < released_ + slots_.size(); });
+          if (stop_)
+            return;
+          target = &slots_[chunk % slots_.size()];
+        }
+        const uint64_t offset = static_cast<uint64_t>(chunk) * chunk_bytes_;
+        const size_t bytes = static_cast<size_t>(std::min<uint64_t>(chunk_bytes_, file_size_ - offset));
+        target->buffer.resize(bytes);
+        size_t done = 0;
+#if defined(__unix__) || defined(__APPLE__)
+        while (done < bytes) {
+          const ssize_t count = ::pread(fd_, target->buffer.data() + done, bytes - done, static_cast<off_t>(offset + done));
+          if (count <= 0)
+            break;
+          done += static_cast<size_t>(count);
+        }
+#else
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(target->buffer.data(), static_cast<std::streamsize>(bytes));
+        done = static_cast<size_t>(file.gcount());
+#endif
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          target->size = done;
+          target->chunk = chunk;
+        }
+        changed_.notify_all();
+      }
+    }
+    const std::string path_;
+    const size_t chunk_bytes_;
+    size_t chunk_count_;
+    uint64_t file_size_;
+    std::vector<slot> slots_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    size_t next_chunk_; // next chunk to be claimed by a reader thread
+    size_t consumed_; // chunks handed to the consumer
+    size_t released_; // chunks the consumer is done with
+    bool stop_;
+    bool open_;
+#if defined(__unix__) || defined(__APPLE__)
+    int fd_;
+#endif
+  };
+
+  // async_chunk_range - single pass range of string_ref chunks, a chunk stays valid until the next increment
+  class async_chunk_range {
+  public:
+    class iterator {
+    public:
+      typedef std::input_iterator_tag iterator_category;
+      typedef string_ref value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const string_ref* pointer;
+      typedef const string_ref& reference;
+      iterator() : reader_(nullptr) {}
+      explicit iterator(async_chunk_reader* reader) : reader_(reader) { read(); }
+      reference operator*() const { return chunk_; }
+      pointer operator->() const { return &chunk_; }
+      iterator& operator++() {
+        read();
+        return *this;
+      }
+      bool operator==(const iterator& other) const { return reader_ == other.reader_; }
+      bool operator!=(const iterator& other) const { return reader_ != other.reader_; }
+    private:
+      void read() {
+        if (!reader_->next(chunk_))
+          reader_ = nullptr;
+      }
+      async_chunk_reader* reader_;
+      string_ref chunk_;
+    };
+    typedef iterator const_iterator;
+    typedef string_ref value_type;
+    explicit async_chunk_range(const std::shared_ptr<async_chunk_reader>& reader) : reader_(reader) {}
+    bool is_open() const { return reader_->is_open(); }
+    uint64_t file_size() const { return reader_->file_size(); }
+    bool empty() const { return reader_->file_size() == 0; }
+    iterator begin() const { return iterator(reader_.get()); }
+    iterator end() const { return iterator(); }
+  private:
+    std::shared_ptr<async_chunk_reader> reader_;
+  };
+}
+
+
+/// serialize, deserialize, deserialize_view
+namespace UnderscoreDetail {
+  // serial_format - fixed width little endian values, or LEB128 varints for integers and lengths
+  enum class serial_format : uint8_t { fixed = 0, varint = 1 };
+
+  // zigzag - maps signed integers to unsigned so small magnitudes stay small as varints
+  inline uint64_t zigzag_encode(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+  inline int64_t zigzag_decode(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+  // varint - LEB128, seven bits per byte with the high bit marking a continuation
+  inline void append_varint(std::vector<char>& bytes, uint64_t value) {
+    for (; value >= 0x80; value >>= 7)
+      bytes.push_back(static_cast<char>(value | 0x80));
+    bytes.push_back(static_cast<char>(value));
+  }
+  inline bool decode_varint(const char*& position, const char* last, uint64_t& value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && position != last; shift += 7) {
+      const uint8_t byte = static_cast<uint8_t>(*position++);
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // array_ref - non owning contiguous range, a deserialized view into the serialized bytes
+  template <typename T>
+  class array_ref {
+  public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T& reference;
+    typedef const T& const_reference;
+    typedef const T* pointer;
+    typedef const T* const_pointer;
+    typedef const T* iterator;
+    typedef const T* const_iterator;
+    array_ref() : data_(nullptr), size_(0) {}
+    array_ref(const T* data, size_t size) : data_(data), size_(size) {}
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T& operator[](size_t idx) const { return data_[idx]; }
+    const T& front() const { return data_[0]; }
+    const T& back() const { return data_[size_ - 1]; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+  private:
+    const T* data_;
+    size_t size_;
+  };
+
+  // serial_writer - appends the encoding to a byte vector, lengths and bulk arrays are aligned in the fixed format
+  class serial_writer {
+  public:
+    serial_writer(std::vector<char>& bytes, serial_format format) : bytes_(bytes), format_(format) {}
+    serial_format format() const { return format_; }
+    void write_bytes(const void* data, size_t size) {
+      const char* first = static_cast<const char*>(data);
+      bytes_.insert(bytes_.end(), first, first + size);
+    }
+    template <typename UnsignedType>
+    void write_fixed(UnsignedType value) {
+      char bytes[sizeof(UnsignedType)];
+      for (size_t i = 0; i < sizeof(UnsignedType); ++i)
+        bytes[i] = static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+      write_bytes(bytes, sizeof(UnsignedType));
+    }
+    void write_varint(uint64_t value) { append_varint(bytes_, value); }
+    void write_size(uint64_t size) {
+      if (format_ == serial_format::varint)
+        write_varint(size);
+      else
+        write_fixed(size);
+    }
+    void align(size_t alignment) {
+      if (format_ == serial_format::fixed)
+        bytes_.resize((bytes_.size() + alignment - 1) / alignment * alignment, '\0');
+    }
+  private:
+    serial_writer& operator=(const serial_writer&);
+    std::vector<char>& bytes_;
+    serial_format format_;
+  };
+
+  // serial_reader - bounds checked cursor, once a read runs past the end every following read fails
+  class serial_reader {
+  public:
+    serial_reader(const char* first, const char* last)
+    : first_(first), position_(first), last_(last), format_(serial_format::fixed), ok_(true) {}
+    bool ok() const { return ok_; }
+    void fail() { ok_ = false; }
+    serial_format format() const { return format_; }
+    void set_format(serial_format format) { format_ = format; }
+    size_t remaining() const { return static_cast<size_t>(last_ - position_); }
+    const char* take(size_t size) {
+      if (!ok_ || remaining() < size) {
+        ok_ = false;
+        return nullptr;
+      }
+      const char* bytes = position_;
+      position_ += size;
+      return bytes;
+    }
+    template <typename UnsignedType>
+    UnsignedType read_fixed() {
+      const char* bytes = take(sizeof(UnsignedType));
+      uint64_t value = 0;
+      for (size_t i = 0; bytes != nullptr && i < sizeof(UnsignedType); ++i)
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+      return static_cast<UnsignedType>(value);
+    }
+    uint64_t read_varint() {
+      uint64_t value = 0;
+      if (ok_ && !decode_varint(position_, last_, value))
+        ok_ = false;
+      return value;
+    }
+    uint64_t read_size() { return format_ == serial_format::varint ? read_varint() : read_fixed<uint64_t>(); }
+    void align(size_t alignment) {
+      if (format_ == serial_format::fixed)
+        take((alignment - static_cast<size_t>(position_ - first_) % alignment) % alignment);
+    }
+  private:
+    const char* first_;
+    const char* position_;
+    const char* last_;
+    serial_format format_;
+    bool ok_;
+  };
+
+  // serial_kind - how a type is encoded
+  enum serial_kind { serial_arithmetic, serial_enum, serial_pair, serial_tuple, serial_array, serial_container, serial_raw };
+  template <typename T>
+  struct serial_kind_of : std::integral_constant<int,
+    std::is_arithmetic<T>::value ? serial_arithmetic :
+    std::is_enum<T>::value ? serial_enum :
+    is_iterable<T>::value ? serial_container : serial_raw> {};
+  template <typename FirstType, typename SecondType>
+  struct serial_kind_of<std::pair<FirstType, SecondType> > : std::integral_constant<int, serial_pair> {};
+  template <typename... Types>
+  struct serial_kind_of<std::tuple<Types...> > : std::integral_constant<int, serial_tuple> {};
+  template <typename T, size_t N>
+  struct serial_kind_of<std::array<T, N> > : std::integral_constant<int, serial_array> {};
+
+  // serial_element - the element type to decode, map keys lose their const
+  template <typename T>
+  struct serial_element { typedef T type; };
+  template <typename KeyType, typename ValueType>
+  struct serial_element<std::pair<const KeyType, ValueType> > { typedef std::pair<KeyType, ValueType> type; };
+
+  // is_serial_bulk - element types whose arrays are a single memcpy, arithmetic types need a little endian host
+  template <typename T>
+  struct is_serial_bulk : std::integral_constant<bool,
+    serial_kind_of<T>::value == serial_raw ||
+    (UNDERSCORE_LITTLE_ENDIAN && std::is_arithmetic<T>::value && !std::is_same<T, bool>::value)> {};
+  template <typename T>
+  bool is_serial_bulk_format(serial_format format) {
+    return format == serial_format::fixed || !std::is_integral<T>::value || sizeof(T) == 1;
+  }
+  template <typename T>
+  struct is_contiguous_container<array_ref<T> > : std::true_type {};
+
+  // serial_bulk_view - zero copy view of a bulk array, strings become string_ref
+  template <typename ContainerType, typename ElementType>
+  struct serial_bulk_view {
+    typedef array_ref<ElementType> type;
+    static type make(const ElementType* data, size_t size) { return type(data, size); }
+  };
+  template <typename TraitsType, typename AllocType>
+  struct serial_bulk_view<std::basic_string<char, TraitsType, AllocType>, char> {
+    typedef string_ref type;
+    static type make(const char* data, size_t size) { return type(data, size); }
+  };
+
+  // serializer - write, read and read_view of each serial_kind
+  template <typename T, int Kind = serial_kind_of<T>::value>
+  struct serializer;
+  template <typename T>
+  struct serializer<T, serial_arithmetic> {
+    typedef T view_type;
+    typedef typename std::conditional<sizeof(T) == 1, uint8_t,
+      typename std::conditional<sizeof(T) == 2, uint16_t,
+      typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type bits_type;
+    UNDERSCORE_STATIC_ASSERT(sizeof(T) <= sizeof(uint64_t), "serialize supports arithmetic types of at most 64 bits");
+    static void write(serial_writer& writer, const T& value) {
+      if (!is_serial_bulk_format<T>(writer.format()))
+        writer.write_varint(std::is_signed<T>::value ? zigzag_encode(static_cast<int64_t>(value)) : static_cast<uint64_t>(value));
+      else {
+        bits_type bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        writer.write_fixed(bits);
+      }
+    }
+    static void read(serial_reader& reader, T& value) {
+      if (!is_serial_bulk_format<T>(reader.format())) {
+        const uint64_t bits = reader.read_varint();
+        value = std::is_signed<T>::value ? static_cast<T>(zigzag_decode(bits)) : static_cast<T>(bits);
+      }
+      else {
+        const bits_type bits = reader.read_fixed<bits_type>();
+        std::memcpy(&value, &bits, sizeof(T));
+      }
+    }
+    static view_type read_view(serial_reader& reader) {
+      T value = T();
+      read(reader, value);
+      return value;
+    }
+  };
+  template <typename T>
+  struct serializer<T, serial_enum> {
+    typedef T view_type;
+    typedef typename std::underlying_type<T>::type underlying_type;
+    static void write(serial_writer& writer, const T& value) {
+      serializer<underlying_type>::write(writer, static_cast<underlying_type>(value));
+    }
+    static void read(serial_reader& reader, T& value) {
+      underlying_type underlying = underlying_type();
+      serializer<underlying_type>::read(reader, underlying);
+      value = static_cast<T>(underlying);
+    }
+    static view_type read_view(serial_reader& reader) {
+      T value = T();
+      read(reader, value);
+      return value;
+    }
+  };
+  template <typename T>
+  struct serializer<T, serial_raw> {
+    typedef T view_type;
+    UNDERSCORE_STATIC_ASSERT(std::is_trivially_copyable<T>::value, "serialize needs arithmetic, enum, pair, tuple, container or trivially copyable types");
+    static void write(serial_writer& writer, const T& value) { writer.write_bytes(&value, sizeof(T)); }
+    static void read(serial_reader& reader, T& value) {
+      if (const char* bytes = reader.take(sizeof(T)))
+        std::memcpy(&value, bytes, sizeof(T));
+    }
+    static view_type read_view(serial_reader& reader) {
+      T value = T();
+      read(reader, value);
+      return value;
+    }
+  };
+  template <typename FirstType, typename SecondType>
+  struct serializer<std::pair<FirstType, SecondType>, serial_pair> {
+    typedef std::pair<typename serializer<FirstType>::view_type, typename serializer<SecondType>::view_type> view_type;
+    template <typename PairType> // also std::pair<const Key, Value> of maps
+    static void write(serial_writer& writer, const PairType& value) {
+      serializer<FirstType>::write(writer, value.first);
+      serializer<SecondType>::write(writer, value.second);
+    }
+    static void read(serial_reader& reader, std::pair<FirstType, SecondType>& value) {
+      serializer<FirstType>::read(reader, value.first);
+      serializer<SecondType>::read(reader, value.second);
+    }
+    static view_type read_view(serial_reader& reader) {
+      typename serializer<FirstType>::view_type first = serializer<FirstType>::read_view(reader);
+      return view_type(first, serializer<SecondType>::read_view(reader));
+    }
+  };
+  template <typename... Types>
+  struct serializer<std::tuple<Types...>, serial_tuple> {
+    typedef std::tuple<typename serializer<Types>::view_type...> view_type;
+    typedef std::integral_constant<size_t, sizeof...(Types)> size_type;
+    template <size_t Idx>
+    static void write_from(serial_writer&, const std::tuple<Types...>&, std::integral_constant<size_t, Idx>, std::true_type /*done*/) {}
+    template <size_t Idx>
+    static void write_from(serial_writer& writer, const std::tuple<Types...>& value, std::integral_constant<size_t, Idx>, std::false_type) {
+      typedef typename std::tuple_element<Idx, std::tuple<Types...> >::type ElementType;
+      serializer<ElementType>::write(writer, std::get<Idx>(value));
+      write_from(writer, value, std::integral_constant<size_t, Idx + 1>(), std::integral_constant<bool, Idx + 1 == size_type::value>());
+    }
+    template <size_t Idx>
+    static void read_from(serial_reader&, std::tuple<Types...>&, std::integral_constant<size_t, Idx>, std::true_type /*done*/) {}
+    template <size_t Idx>
+    static void read_from(serial_reader& reader, std::tuple<Types...>& value, std::integral_constant<size_t, Idx>, std::false_type) {
+      typedef typename std::tuple_element<Idx, std::tuple<Types...> >::type ElementType;
+      serializer<ElementType>::read(reader, std::get<Idx>(value));
+      read_from(reader, value, std::integral_constant<size_t, Idx + 1>(), std::integral_constant<bool, Idx + 1 == size_type::value>());
+    }
+    template <size_t Idx>
+    static void view_from(serial_reader&, view_type&, std::integral_constant<size_t, Idx>, std::true_type /*done*/) {}
+    template <size_t Idx>
+    static void view_from(serial_reader& reader, view_type& value, std::integral_constant<size_t, Idx>, std::false_type) {
+      typedef typename std::tuple_element<Idx, std::tuple<Types...> >::type ElementType;
+      std::get<Idx>(value) = serializer<ElementType>::read_view(reader);
+      view_from(reader, value, std::integral_constant<size_t, Idx + 1>(), std::integral_constant<bool, Idx + 1 == size_type::value>());
+    }
+    static void write(serial_writer& writer, const std::tuple<Types...>& value) {
+      write_from(writer, value, std::integral_constant<size_t, 0>(), std::integral_constant<bool, size_type::value == 0>());
+    }
+    static void read(serial_reader& reader, std::tuple<Types...>& value) {
+      read_from(reader, value, std::integral_constant<size_t, 0>(), std::integral_constant<bool, size_type::value == 0>());
+    }
+    static view_type read_view(serial_reader& reader) {
+      view_type value;
+      view_from(reader, value, std::integral_constant<size_t, 0>(), std::integral_constant<bool, size_type::value == 0>());
+      return value;
+    }
+  };
+  template <typename T, size_t N>
+  struct serializer<std::array<T, N>, serial_array> {
+    typedef std::array<T, N> view_type; // fixed size arrays are copied
+    static void write_elements(serial_writer& writer, const std::array<T, N>& value, std::true_type /*is_bulk*/) {
+      if (!is_serial_bulk_format<T>(writer.format()))
+        return write_elements(writer, value, std::false_type());
+      writer.align(alignof(T));
+      writer.write_bytes(value.data(), N * sizeof(T));
+    }
+    static void write_elements(serial_writer& writer, const std::array<T, N>& value, std::false_type) {
+      for (size_t i = 0; i < N; ++i)
+        serializer<T>::write(writer, value[i]);
+    }
+    static void read_elements(serial_reader& reader, std::array<T, N>& value, std::true_type /*is_bulk*/) {
+      if (!is_serial_bulk_format<T>(reader.format()))
+        return read_elements(reader, value, std::false_type());
+      reader.align(alignof(T));
+      if (const char* bytes = reader.take(N * sizeof(T)))
+        std::memcpy(value.data(), bytes, N * sizeof(T));
+    }
+    static void read_elements(serial_reader& reader, std::array<T, N>& value, std::false_type) {
+      for (size_t i = 0; i < N; ++i)
+        serializer<T>::read(reader, value[i]);
+    }
+    static void write(serial_writer& writer, const std::array<T, N>& value) {
+      write_elements(writer, value, std::integral_constant<bool, is_serial_bulk<T>::value>());
+    }
+    static void read(serial_reader& reader, std::array<T, N>& value) {
+      read_elements(reader, value, std::integral_constant<bool, is_serial_bulk<T>::value>());
+    }
+    static view_type read_view(serial_reader& reader) {
+      view_type value = view_type();
+      read(reader, value);
+      return value;
+    }
+  };
+
+  // serial_insert - push_back for sequences, insert for sets and maps
+  template <typename ContainerType, typename ValueType>
+  auto serial_insert(ContainerType& container, ValueType&& value, int) -> decltype(container.push_back(std::forward<ValueType>(value)), void()) {
+    container.push_back(std::forward<ValueType>(value));
+  }
+  template <typename ContainerType, typename ValueType>
+  void serial_insert(ContainerType& container, ValueType&& value, long) {
+    container.insert(std::forward<ValueType>(value));
+  }
+  template <typename ContainerType>
+  auto serial_reserve(ContainerType& container, size_t size, int) -> decltype(container.reserve(size), void()) {
+    container.reserve(size);
+  }
+  template <typename ContainerType>
+  void serial_reserve(ContainerType&, size_t, long) {}
+
+  // Containers are a length followed by the elements, contiguous containers of bulk elements are a single copy
+  // and views of them point straight into the serialized bytes
+  template <typename T>
+  struct serializer<T, serial_container> {
+    typedef typename serial_element<typename T::value_type>::type element_type;
+    typedef std::integral_constant<bool, is_contiguous_container<T>::value && is_serial_bulk<element_type>::value> is_bulk;
+    typedef typename std::conditional<is_bulk::value,
+      typename serial_bulk_view<T, element_type>::type,
+      std::vector<typename serializer<element_type>::view_type> >::type view_type;
+    static void write_elements(serial_writer& writer, const T& container, size_t size, std::true_type /*is_bulk*/) {
+      if (!is_serial_bulk_format<element_type>(writer.format()))
+        return write_elements(writer, container, size, std::false_type());
+      writer.align(alignof(element_type));
+      if (size != 0)
+        writer.write_bytes(std::addressof(*std::begin(container)), size * sizeof(element_type));
+    }
+    static void write_elements(serial_writer& writer, const T& container, size_t, std::false_type) {
+      for (auto it = std::begin(container); it != std::end(container); ++it)
+        serializer<element_type>::write(writer, *it);
+    }
+    static void read_elements(serial_reader& reader, T& container, uint64_t size, std::true_type /*is_bulk*/) {
+      if (!is_serial_bulk_format<element_type>(reader.format()))
+        return read_elements(reader, container, size, std::false_type());
+      reader.align(alignof(element_type));
+      if (size > reader.remaining() / sizeof(element_type))
+        return reader.fail();
+      const char* bytes = reader.take(static_cast<size_t>(size) * sizeof(element_type));
+      container.resize(static_cast<size_t>(size));
+      if (size != 0)
+        std::memcpy(std::addressof(*std::begin(container)), bytes, static_cast<size_t>(size) * sizeof(element_type));
+    }
+    static void read_elements(serial_reader& reader, T& container, uint64_t size, std::false_type) {
+      serial_reserve(container, static_cast<size_t>(std::min<uint64_t>(size, reader.remaining())), 0);
+      for (uint64_t i = 0; i < size && reader.ok(); ++i) {
+        element_type element = element_type();
+        serializer<element_type>::read(reader, element);
+        if (reader.ok())
+          serial_insert(container, std::move(element), 0);
+      }
+    }
+    static view_type view_elements(serial_reader& reader, uint64_t size, std::true_type /*is_bulk*/) {
+      reader.align(alignof(element_type));
+      if (!is_serial_bulk_format<element_type>(reader.format()) || size > reader.remaining() / sizeof(element_type)) {
+        reader.fail(); // varint encoded integers have no contiguous representation to point into
+        return view_type();
+      }
+      const char* bytes = reader.take(static_cast<size_t>(size) * sizeof(element_type));
+      if (reinterpret_cast<uintptr_t>(bytes) % alignof(element_type) != 0) {
+        reader.fail(); // the serialized bytes do not start at an aligned address
+        return view_type();
+      }
+      return serial_bulk_view<T, element_type>::make(reinterpret_cast<const element_type*>(bytes), static_cast<size_t>(size));
+    }
+    static view_type view_elements(serial_reader& reader, uint64_t size, std::false_type) {
+      view_type views;
+      views.reserve(static_cast<size_t>(std::min<uint64_t>(size, reader.remaining())));
+      for (uint64_t i = 0; i < size && reader.ok(); ++i)
+        views.push_back(serializer<element_type>::read_view(reader));
+      return views;
+    }
+    static void write(serial_writer& writer, const T& container) {
+      const size_t size = static_cast<size_t>(std::distance(std::begin(container), std::end(container)));
+      writer.write_size(size);
+      write_elements(writer, container, size, is_bulk());
+    }
+    static void read(serial_reader& reader, T& container) {
+      container.clear();
+      const uint64_t size = reader.read_size();
+      read_elements(reader, container, size, is_bulk());
+    }
+    static view_type read_view(serial_reader& reader) {
+      const uint64_t size = reader.read_size();
+      return view_elements(reader, size, is_bulk());
+    }
+  };
+
+  // serialize - a four byte header, "US", the version and the serial_format, followed by the value
+  template <typename T>
+  std::vector<char> serialize(const T& value, serial_format format) {
+    std::vector<char> bytes;
+    serial_writer writer(bytes, format);
+    const char header[] = { 'U', 'S', 1, static_cast<char>(format) };
+    writer.write_bytes(header, sizeof(header));
+    serializer<T>::write(writer, value);
+    return bytes;
+  }
+  template <typename ContainerType>
+  serial_reader make_serial_reader(const ContainerType& bytes) {
+    const size_t size = static_cast<size_t>(std::distance(std::begin(bytes), std::end(bytes))) * sizeof(*std::begin(bytes));
+    const char* first = size == 0 ? nullptr : reinterpret_cast<const char*>(std::addressof(*std::begin(bytes)));
+    serial_reader reader(first, first + size);
+    const char* header = reader.take(4);
+    if (header == nullptr || header[0] != 'U' || header[1] != 'S' || header[2] != 1 || (header[3] != 0 && header[3] != 1))
+      reader.fail();
+    else
+      reader.set_format(static_cast<serial_format>(header[3]));
+    return reader;
+  }
+}
+namespace UnderscoreTags {
+  IMPLEMENTS_1_ARG_TAG( SerializeTag )
+  struct SerializeTag {
+    SerializeTag() {}
+    SerializeTag& operator=(const SerializeTag&);
+    IMPLEMENTS_1_ARG_OPERATOR( SerializeTag )
+  };
+}
+template <typename ValueType>
+std::vector<char>
+PIPE_OPERATOR(const ValueType& value, const UnderscoreTags::SerializeTag&) {
+  return UnderscoreDetail::serialize(value, UnderscoreDetail::serial_format::fixed);
+}
+template <typename ValueType> // serial_format
+std::vector<char>
+PIPE_OPERATOR(const ValueType& value, const UnderscoreTags::SerializeTag1Arg<UnderscoreDetail::serial_format>& tag) {
+  return UnderscoreDetail::serialize(value, tag.arg0);
+}
+CREATE_TAG_TEMPLATE( DeserializeTag );
+template <typename ContainerType, typename ValueType> // a value initialized ValueType when the bytes are malformed
+ValueType
+PIPE_OPERATOR(const ContainerType& bytes, const UnderscoreTags::DeserializeTag<ValueType>&) {
+  UnderscoreDetail::serial_reader reader = UnderscoreDetail::make_serial_reader(bytes);
+  ValueType value = ValueType();
+  UnderscoreDetail::serializer<ValueType>::read(reader, value);
+  UNDERSCORE_ASSERT(reader.ok());
+  if (!reader.ok())
+    value = ValueType();
+  return value;
+}
+CREATE_TAG_TEMPLATE( TryDeserializeTag );
+template <typename ContainerType, typename ValueType>
+UnderscoreDetail::optional<ValueType>
+PIPE_OPERATOR(const ContainerType& bytes, const UnderscoreTags::TryDeserializeTag<ValueType>&) {
+  UnderscoreDetail::serial_reader reader = UnderscoreDetail::make_serial_reader(bytes);
+  ValueType value = ValueType();
+  UnderscoreDetail::serializer<ValueType>::read(reader, value);
+  if (!reader.ok())
+    return UnderscoreDetail::optional<ValueType>();
+  return UnderscoreDetail::optional<ValueType>(std::move(value));
+}
+CREATE_TAG_TEMPLATE( DeserializeViewTag );
+template <typename ContainerType, typename ValueType> // views point into bytes, which must outlive them
+typename UnderscoreDetail::serializer<ValueType>::view_type
+PIPE_OPERATOR(const ContainerType& bytes, const UnderscoreTags::DeserializeViewTag<ValueType>&) {
+  typedef typename UnderscoreDetail::serializer<ValueType>::view_type ViewType;
+  UnderscoreDetail::serial_reader reader = UnderscoreDetail::make_serial_reader(bytes);
+  ViewType view = UnderscoreDetail::serializer<ValueType>::read_view(reader);
+  UNDERSCORE_ASSERT(reader.ok());
+  if (!reader.ok())
+    view = ViewType();
+  return view;
+}
+
+/// delta_encode, delta_decode, zigzag, unzigzag, varint_encode, varint_decode
+namespace UnderscoreDetail {
+  // Differences and sums are computed in the unsigned type so they wrap instead of overflowing
+  template <typename ContainerType>
+  std::vector<typename ContainerType::value_type> delta_encode(const ContainerType& container) {
+    typedef typename ContainerType::value_type ValueType;
+    typedef typename std::make_unsigned<ValueType>::type UnsignedType;
+    std::vector<ValueType> deltas;
+    deltas.reserve(container.size());
+    UnsignedType previous = 0;
+    for (auto it = std::begin(container); it != std::end(container); ++it) {
+      const UnsignedType current = static_cast<UnsignedType>(*it);
+      deltas.push_back(static_cast<ValueType>(static_cast<UnsignedType>(current - previous)));
+      previous = current;
+    }
+    return deltas;
+  }
+  template <typename ContainerType>
+  std::vector<typename ContainerType::value_type> delta_decode(const ContainerType& container) {
+    typedef typename ContainerType::value_type ValueType;
+    typedef typename std::make_unsigned<ValueType>::type UnsignedType;
+    std::vector<ValueType> values;
+    values.reserve(container.size());
+    UnsignedType sum = 0;
+    for (auto it = std::begin(container); it != std::end(container); ++it) {
+      sum = static_cast<UnsignedType>(sum + static_cast<UnsignedType>(*it));
+      values.push_back(static_cast<ValueType>(sum));
+    }
+    return values;
+  }
+  template <typename SignedType>
+  typename std::make_unsigned<SignedType>::type zigzag(SignedType value) {
+    typedef typename std::make_unsigned<SignedType>::type UnsignedType;
+    return static_cast<UnsignedType>(static_cast<UnsignedType>(static_cast<UnsignedType>(value) << 1) ^ static_cast<UnsignedType>(value >> (sizeof(SignedType) * 8 - 1)));
+  }
+  template <typename UnsignedType>
+  typename std::make_signed<UnsignedType>::type unzigzag(UnsignedType value) {
+    typedef typename std::make_signed<UnsignedType>::type SignedType;
+    return static_cast<SignedType>(static_cast<UnsignedType>(value >> 1) ^ static_cast<UnsignedType>(0 - (value & 1)));
+  }
+}
+CREATE_TAG_0_ARG( DeltaEncodeTag );
+template <typename ContainerType> // container of integers, the first delta is the first value
+std::vector<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::DeltaEncodeTag&) {
+  return UnderscoreDetail::delta_encode(container);
+}
+CREATE_TAG_0_ARG( DeltaDecodeTag );
+template <typename ContainerType>
+std::vector<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::DeltaDecodeTag&) {
+  return UnderscoreDetail::delta_decode(container);
+}
+CREATE_TAG_0_ARG( ZigzagTag );
+template <typename ContainerType> // container of signed integers
+std::vector<typename std::make_unsigned<typename ContainerType::value_type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ZigzagTag&) {
+  std::vector<typename std::make_unsigned<typename ContainerType::value_type>::type> result;
+  result.reserve(container.size());
+  for (auto it = std::begin(container); it != std::end(container); ++it)
+    result.push_back(UnderscoreDetail::zigzag(*it));
+  return result;
+}
+CREATE_TAG_0_ARG( UnzigzagTag );
+template <typename ContainerType> // container of unsigned integers
+std::vector<typename std::make_signed<typename ContainerType::value_type>::type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::UnzigzagTag&) {
+  std::vector<typename std::make_signed<typename ContainerType::value_type>::type> result;
+  result.reserve(container.size());
+  for (auto it = std::begin(container); it != std::end(container); ++it)
+    result.push_back(UnderscoreDetail::unzigzag(*it));
+  return result;
+}
+CREATE_TAG_0_ARG( VarintEncodeTag );
+template <typename ContainerType> // container of integers, signed values are zigzag encoded
+std::vector<char>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::VarintEncodeTag&) {
+  typedef typename ContainerType::value_type ValueType;
+  UNDERSCORE_STATIC_ASSERT(std::is_integral<ValueType>::value, "varint_encode needs a container of integers");
+  std::vector<char> bytes;
+  bytes.reserve(container.size() * 2);
+  for (auto it = std::begin(container); it != std::end(container); ++it)
+    UnderscoreDetail::append_varint(bytes, std::is_signed<ValueType>::value ? UnderscoreDetail::zigzag_encode(static_cast<int64_t>(*it)) : static_cast<uint64_t>(*it));
+  return bytes;
+}
+CREATE_TAG_TEMPLATE( VarintDecodeTag );
+template <typename ContainerType, typename ValueType> // container of bytes, decoding stops at a truncated varint
+std::vector<ValueType>
+PIPE_OPERATOR(const ContainerType& bytes, const UnderscoreTags::VarintDecodeTag<ValueType>&) {
+  UNDERSCORE_STATIC_ASSERT(std::is_integral<ValueType>::value, "varint_decode decodes integers");
+  std::vector<ValueType> values;
+  if (bytes.size() == 0)
+    return values;
+  const char* position = reinterpret_cast<const char*>(std::addressof(*std::begin(bytes)));
+  const char* const last = position + bytes.size();
+  uint64_t value = 0;
+  while (position != last && UnderscoreDetail::decode_varint(position, last, value))
+    values.push_back(std::is_signed<ValueType>::value ? static_cast<ValueType>(UnderscoreDetail::zigzag_decode(value)) : static_cast<ValueType>(value));
+  return values;
+}
+
+/// bitpack
+namespace UnderscoreDetail {
+  // bitpacked - frame of reference bit packing in blocks of 128 integers, SIMD-BP128 layout.
+  // Each block stores its minimum and the offsets from it in the fewest bits that fit the largest offset,
+  // value i of a block lives in 32 bit lane i % 4 so four values unpack per SSE2 shift and mask.
+  // Sorted integers give small offsets and pack well, any value stays randomly accessible.
+  template <typename T>
+  class bitpacked {
+  public:
+    UNDERSCORE_STATIC_ASSERT(std::is_integral<T>::value && sizeof(T) <= sizeof(uint32_t), "bitpack packs integers of at most 32 bits");
+    enum { block_size = 128, lane_count = 4, lane_values = block_size / lane_count };
+    typedef T value_type;
+    typedef size_t size_type;
+    class const_iterator {
+    public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef T value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const T* pointer;
+      typedef T reference;
+      const_iterator() : packed_(nullptr), index_(0) {}
+      const_iterator(const bitpacked* packed, size_t index) : packed_(packed), index_(index) {}
+      T operator*() const { return (*packed_)[index_]; }
+      T operator[](difference_type offset) const { return (*packed_)[index_ + offset]; }
+      const_iterator& operator++() { ++index_; return *this; }
+      const_iterator operator++(int) { const_iterator previous = *this; ++index_; return previous; }
+      const_iterator& operator--() { --index_; return *this; }
+      const_iterator operator--(int) { const_iterator previous = *this; --index_; return previous; }
+      const_iterator& operator+=(difference_type offset) { index_ += offset; return *this; }
+      const_iterator& operator-=(difference_type offset) { index_ -= offset; return *this; }
+      const_iterator operator+(difference_type offset) const { return const_iterator(packed_, index_ + offset); }
+      const_iterator operator-(difference_type offset) const { return const_iterator(packed_, index_ - offset); }
+      difference_type operator-(const const_iterator& other) const { return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_); }
+      bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+      bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+      bool operator<(const const_iterator& other) const { return index_ < other.index_; }
+      bool operator>(const const_iterator& other) const { return index_ > other.index_; }
+      bool operator<=(const const_iterator& other) const { return index_ <= other.index_; }
+      bool operator>=(const const_iterator& other) const { return index_ >= other.index_; }
+    private:
+      const bitpacked* packed_;
+      size_t index_;
+    };
+    typedef const_iterator iterator;
+
+    bitpacked() : size_(0) {}
+    template <typename IteratorType>
+    bitpacked(IteratorType first, IteratorType last) : size_(0) {
+      uint32_t offsets[block_size];
+      while (first != last) {
+        size_t count = 0;
+        uint32_t minimum = 0;
+        for (; first != last && count < block_size; ++first, ++count) {
+          offsets[count] = static_cast<uint32_t>(static_cast<T>(*first));
+          if (count == 0 || less(offsets[count], minimum))
+            minimum = offsets[count];
+        }
+        uint32_t combined = 0;
+        for (size_t i = 0; i < count; ++i) {
+          offsets[i] -= minimum;
+          combined |= offsets[i];
+        }
+        std::fill(offsets + count, offsets + block_size, 0u);
+        block_header header;
+        header.minimum = minimum;
+        header.bits = bit_width(combined);
+        header.word_offset = words_.size();
+        blocks_.push_back(header);
+        words_.resize(words_.size() + header.bits * lane_count, 0u);
+        pack(offsets, header.bits, words_.data() + header.word_offset);
+        size_ += count;
+      }
+    }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t compressed_bytes() const { return words_.size() * sizeof(uint32_t) + blocks_.size() * sizeof(block_header); }
+    T operator[](size_t idx) const {
+      UNDERSCORE_ASSERT(idx < size_);
+      const block_header& header = blocks_[idx / block_size];
+      if (header.bits == 0)
+        return static_cast<T>(header.minimum);
+      const size_t in_block = idx % block_size;
+      const size_t bit = (in_block / lane_count) * header.bits;
+      const uint32_t* lane = words_.data() + header.word_offset + in_block % lane_count;
+      const size_t shift = bit % 32;
+      uint64_t bits = lane[(bit / 32) * lane_count] >> shift;
+      if (shift + header.bits > 32)
+        bits |= static_cast<uint64_t>(lane[(bit / 32 + 1) * lane_count]) << (32 - shift);
+      return static_cast<T>(static_cast<uint32_t>(header.minimum + (static_cast<uint32_t>(bits) & mask(header.bits))));
+    }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+    // decode - unpacks every value to out, which has room for size() values
+    void decode(T* out) const {
+      uint32_t values[block_size];
+      for (size_t block = 0; block < blocks_.size(); ++block) {
+        const block_header& header = blocks_[block];
+        unpack(words_.data() + header.word_offset, header.bits, header.minimum, values);
+        const size_t count = std::min<size_t>(block_size, size_ - block * block_size);
+        for (size_t i = 0; i < count; ++i)
+          out[block * block_size + i] = static_cast<T>(values[i]);
+      }
+    }
+    std::vector<T> to_vector() const {
+      std::vector<T> values(size_);
+      if (size_ != 0)
+        decode(values.data());
+      return values;
+    }
+  private:
+    struct block_header {
+      uint32_t minimum;
+      uint32_t bits;
+      size_t word_offset;
+    };
+    static bool less(uint32_t left, uint32_t right) { return static_cast<T>(left) < static_cast<T>(right); }
+    static uint32_t bit_width(uint32_t value) {
+      uint32_t bits = 0;
+      for (; value != 0; value >>= 1)
+        ++bits;
+      return bits;
+    }
+    static uint32_t mask(uint32_t bits) { return bits >= 32 ? ~0u : (1u << bits) - 1; }
+    static void pack(const uint32_t* offsets, uint32_t bits, uint32_t* words) {
+      if (bits == 0)
+        return;
+      for (size_t lane = 0; lane < lane_count; ++lane) {
+        for (size_t j = 0; j < lane_values; ++j) {
+          const uint32_t value = offsets[j * lane_count + lane];
+          const size_t bit = j * bits;
+          const size_t shift = bit % 32;
+          words[(bit / 32) * lane_count + lane] |= value << shift;
+          if (shift + bits > 32)
+            words[(bit / 32 + 1) * lane_count + lane] |= value >> (32 - shift);
+        }
+      }
+    }
+    static void unpack(const uint32_t* words, uint32_t bits, uint32_t minimum, uint32_t* values) {
+#if UNDERSCORE_SSE2
+      const __m128i base = _mm_set1_epi32(static_cast<int>(minimum));
+      if (bits == 0) {
+        for (size_t j = 0; j < lane_values; ++j)
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(values + j * lane_count), base);
+        return;
+      }
+      const __m128i value_mask = _mm_set1_epi32(static_cast<int>(mask(bits)));
+      for (size_t j = 0; j < lane_values; ++j) {
+        const size_t bit = j * bits;
+        const size_t shift = bit % 32;
+        const __m128i* word = reinterpret_cast<const __m128i*>(words + (bit / 32) * lane_count);
+        __m128i lanes = _mm_srl_epi32(_mm_loadu_si128(word), _mm_cvtsi32_si128(static_cast<int>(shift)));
+        if (shift + bits > 32)
+          lanes = _mm_or_si128(lanes, _mm_sll_epi32(_mm_loadu_si128(word + 1), _mm_cvtsi32_si128(static_cast<int>(32 - shift))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + j * lane_count), _mm_add_epi32(_mm_and_si128(lanes, value_mask), base));
+      }
+#else
+      for (size_t lane = 0; lane < lane_count; ++lane) {
+        for (size_t j = 0; j < lane_values; ++j) {
+          uint32_t value = 0;
+          if (bits != 0) {
+            const size_t bit = j * bits;
+            const size_t shift = bit % 32;
+            uint64_t lane_bits = words[(bit / 32) * lane_count + lane] >> shift;
+            if (shift + bits > 32)
+              lane_bits |= static_cast<uint64_t>(words[(bit / 32 + 1) * lane_count + lane]) << (32 - shift);
+            value = static_cast<uint32_t>(lane_bits) & mask(bits);
+          }
+          values[j * lane_count + lane] = minimum + value;
+        }
+      }
+#endif
+    }
+    std::vector<block_header> blocks_;
+    std::vector<uint32_t> words_;
+    size_t size_;
+  };
+}
+CREATE_TAG_0_ARG( BitpackTag );
+template <typename ContainerType> // container of integers of at most 32 bits
+UnderscoreDetail::bitpacked<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::BitpackTag&) {
+  return UnderscoreDetail::bitpacked<typename ContainerType::value_type>(std::begin(container), std::end(container));
+}
+template <typename T>
+std::vector<T>
+PIPE_OPERATOR(const UnderscoreDetail::bitpacked<T>& packed, const UnderscoreTags::ToVectorTag&) {
+  return packed.to_vector();
+}
+
+/// lz4_compress, lz4_decompress
+namespace UnderscoreDetail {
+  // LZ4 block format, a greedy single probe hash matcher. The output is a raw LZ4 block, without the
+  // frame header, so it decodes with LZ4_decompress_safe and the decompressed size is kept by the caller.
+  enum { lz4_min_match = 4, lz4_last_literals = 5, lz4_match_limit = 12, lz4_max_offset = 65535, lz4_hash_bits = 16 };
+  inline uint32_t lz4_read32(const char* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+  }
+  inline void lz4_append_length(std::vector<char>& out, size_t length) {
+    for (; length >= 255; length -= 255)
+      out.push_back(static_cast<char>(255));
+    out.push_back(static_cast<char>(length));
+  }
+  inline void lz4_append_sequence(std::vector<char>& out, const char* literals, size_t literal_count, size_t offset, size_t match_length) {
+    const size_t match_code = match_length == 0 ? 0 : match_length - lz4_min_match;
+    out.push_back(static_cast<char>((std::min<size_t>(literal_count, 15) << 4) | std::min<size_t>(match_code, 15)));
+    if (literal_count >= 15)
+      lz4_append_length(out, literal_count - 15);
+    out.insert(out.end(), literals, literals + literal_count);
+    if (match_length == 0)
+      return; // the last sequence is literals only
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (match_code >= 15)
+      lz4_append_length(out, match_code - 15);
+  }
+  inline std::vector<char> lz4_compress(const char* input, size_t size) {
+    std::vector<char> out;
+    out.reserve(size + size / 255 + 16);
+    std::vector<uint32_t> table(static_cast<size_t>(1) << lz4_hash_bits, 0);
+    size_t anchor = 0;
+    size_t position = 0;
+    while (size >= lz4_match_limit && position + lz4_match_limit <= size) {
+      const uint32_t sequence = lz4_read32(input + position);
+      const uint32_t hash = (sequence * 2654435761u) >> (32 - lz4_hash_bits);
+      const size_t candidate = table[hash];
+      table[hash] = static_cast<uint32_t>(position);
+      if (candidate >= position || position - candidate > lz4_max_offset || lz4_read32(input + candidate) != sequence) {
+        position += 1 + ((position - anchor) >> 6); // skip faster through incompressible data
+        continue;
+      }
+      size_t match_start = position;
+      size_t reference = candidate;
+      while (match_start > anchor && reference > 0 && input[match_start - 1] == input[reference - 1]) {
+        --match_start;
+        --reference;
+      }
+      size_t match_end = position + lz4_min_match;
+      const size_t match_end_limit = size - lz4_last_literals;
+      while (match_end < match_end_limit && input[match_end] == input[reference + (match_end - match_start)])
+        ++match_end;
+      lz4_append_sequence(out, input + anchor, match_start - anchor, match_start - reference, match_end - match_start);
+      position = anchor = match_end;
+    }
+    lz4_append_sequence(out, input + anchor, size - anchor, 0, 0);
+    return out;
+  }
+  // lz4_decompress - false for a malformed block, out holds what was decoded before the error
+  inline bool lz4_decompress(const char* input, size_t size, std::vector<char>& out) {
+    size_t position = 0;
+    while (position < size) {
+      const uint8_t token = static_cast<uint8_t>(input[position++]);
+      size_t literal_count = token >> 4;
+      if (literal_count == 15) {
+        uint8_t byte = 255;
+        while (byte == 255 && position < size)
+          literal_count += byte = static_cast<uint8_t>(input[position++]);
+        if (byte == 255)
+          return false;
+      }
+      if (literal_count > size - position)
+        return false;
+      out.insert(out.end(), input + position, input + position + literal_count);
+      position += literal_count;
+      if (position == size)
+        return true;
+      if (size - position < 2)
+        return false;
+      const size_t offset = static_cast<uint8_t>(input[position]) | static_cast<size_t>(static_cast<uint8_t>(input[position + 1])) << 8;
+      position += 2;
+      size_t match_length = token & 15;
+      if (match_length == 15) {
+        uint8_t byte = 255;
+        while (byte == 255 && position < size)
+          match_length += byte = static_cast<uint8_t>(input[position++]);
+        if (byte == 255)
+          return false;
+      }
+      match_length += lz4_min_match;
+      if (offset == 0 || offset > out.size())
+        return false;
+      size_t source = out.size() - offset;
+      out.resize(out.size() + match_length);
+      char* destination = out.data() + out.size() - match_length;
+      for (size_t i = 0; i < match_length; ++i)
+        destination[i] = out[source + i]; // overlapping copies repeat the pattern
+    }
+    return size == 0;
+  }
+}
+CREATE_TAG_0_ARG( Lz4CompressTag );
+template <typename ContainerType> // contiguous container of bytes
+std::vector<char>
+PIPE_OPERATOR(const ContainerType& bytes, const UnderscoreTags::Lz4CompressTag&) {
+  UNDERSCORE_STATIC_ASSERT(sizeof(typename ContainerType::value_type) == 1, "lz4_compress compresses bytes");
+  if (bytes.size() == 0)
+    return UnderscoreDetail::lz4_compress(nullptr, 0);
+  return UnderscoreDetail::lz4_compress(reinterpret_cast<const char*>(std::addressof(*std::begin(bytes))), bytes.size());
+}
+CREATE_TAG_0_ARG( Lz4DecompressTag );
+template <typename ContainerType> // an LZ4 block, an empty vector when it is malformed
+std::vector<char>
+PIPE_OPERATOR(const ContainerType& bytes, const UnderscoreTags::Lz4DecompressTag&) {
+  UNDERSCORE_STATIC_ASSERT(sizeof(typename ContainerType::value_type) == 1, "lz4_decompress decompresses bytes");
+  std::vector<char> out;
+  out.reserve(bytes.size() * 3);
+  const char* input = bytes.size() == 0 ? nullptr : reinterpret_cast<const char*>(std::addressof(*std::begin(bytes)));
+  if (!UnderscoreDetail::lz4_decompress(input, bytes.size(), out))
+    out.clear();
+  return out;
+}
+
+/// partition_by, par_each_partition
+namespace UnderscoreDetail {
+  // partition_range - mutable view of one partition, index() is its bucket
+  template <typename T>
+  class partition_range {
+  public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    partition_range(T* first, T* last, size_t index) : first_(first), last_(last), index_(index) {}
+    T* data() const { return first_; }
+    size_t size() const { return static_cast<size_t>(last_ - first_); }
+    bool empty() const { return first_ == last_; }
+    size_t index() const { return index_; }
+    T& operator[](size_t idx) const { return first_[idx]; }
+    T* begin() const { return first_; }
+    T* end() const { return last_; }
+  private:
+    T* first_;
+    T* last_;
+    size_t index_;
+  };
+
+  // partitioned - all elements in one buffer grouped by bucket, partition idx is [offsets[idx], offsets[idx + 1]).
+  // Elements keep their input order within a partition.
+  template <typename T>
+  class partitioned {
+  public:
+    UNDERSCORE_STATIC_ASSERT(!std::is_same<T, bool>::value, "partition_by needs contiguous storage");
+    typedef T value_type;
+    typedef typename std::vector<T>::const_iterator iterator;
+    typedef iterator const_iterator;
+    partitioned() : offsets_(1, 0) {}
+    partitioned(std::vector<T>&& elements, std::vector<size_t>&& offsets) : elements_(std::move(elements)), offsets_(std::move(offsets)) {}
+    size_t partition_count() const { return offsets_.size() - 1; }
+    array_ref<T> partition(size_t idx) const { return array_ref<T>(elements_.data() + offsets_[idx], offsets_[idx + 1] - offsets_[idx]); }
+    partition_range<T> partition(size_t idx) { return partition_range<T>(elements_.data() + offsets_[idx], elements_.data() + offsets_[idx + 1], idx); }
+    const std::vector<T>& elements() const { return elements_; }
+    size_t size() const { return elements_.size(); }
+    bool empty() const { return elements_.empty(); }
+    iterator begin() const { return elements_.begin(); }
+    iterator end() const { return elements_.end(); }
+  private:
+    std::vector<T> elements_;
+    std::vector<size_t> offsets_;
+  };
+
+  // partition_bucket - a mask for power of two counts so the low hash bits act as the radix, modulo otherwise
+  class partition_bucket {
+  public:
+    explicit partition_bucket(size_t count) : count_(count), mask_((count & (count - 1)) == 0 ? count - 1 : 0) {}
+    uint32_t operator()(size_t hash) const { return static_cast<uint32_t>(mask_ != 0 || count_ == 1 ? hash & mask_ : hash % count_); }
+  private:
+    size_t count_;
+    size_t mask_;
+  };
+
+  // partition_scatter - write combining, each bucket fills a cache line sized buffer that is flushed with one memcpy,
+  // so the scatter touches n output streams a line at a time instead of an element at a time
+  template <typename T>
+  struct partition_line_slots : std::integral_constant<size_t, 64 / sizeof(T)> {};
+  template <typename IteratorType, typename T>
+  void partition_scatter(IteratorType first, IteratorType last, const uint32_t* bucket_of, size_t* cursor, size_t count, T* out, std::true_type) {
+    const size_t slots = partition_line_slots<T>::value;
+    std::vector<T> lines(count * slots);
+    std::vector<uint8_t> filled(count, 0);
+    for (; first != last; ++first, ++bucket_of) {
+      const uint32_t bucket = *bucket_of;
+      T* line = lines.data() + bucket * slots;
+      line[filled[bucket]] = *first;
+      if (++filled[bucket] == slots) {
+        std::memcpy(out + cursor[bucket], line, slots * sizeof(T));
+        cursor[bucket] += slots;
+        filled[bucket] = 0;
+      }
+    }
+    for (size_t bucket = 0; bucket < count; ++bucket)
+      std::memcpy(out + cursor[bucket], lines.data() + bucket * slots, filled[bucket] * sizeof(T));
+  }
+  template <typename IteratorType, typename T>
+  void partition_scatter(IteratorType first, IteratorType last, const uint32_t* bucket_of, size_t* cursor, size_t, T* out, std::false_type) {
+    for (; first != last; ++first, ++bucket_of)
+      out[cursor[*bucket_of]++] = *first;
+  }
+
+  // partition_by - two passes over per thread chunks: the first hashes every element once and builds a histogram
+  // per chunk, the prefix sum of the histograms (bucket major) gives each chunk a private write cursor per bucket,
+  // the second scatters without any synchronization
+  template <typename ContainerType, typename HashFunctorType>
+  partitioned<typename ContainerType::value_type> partition_by(const ContainerType& container, const HashFunctorType& hash_functor, size_t count) {
+    typedef typename ContainerType::value_type ValueType;
+    typedef typename ContainerType::const_iterator IteratorType;
+    typedef std::integral_constant<bool, std::is_trivially_copyable<ValueType>::value && sizeof(ValueType) <= 32> UseLines;
+    UNDERSCORE_ASSERT(count > 0 && count <= std::numeric_limits<uint32_t>::max());
+    if (count == 0)
+      return partitioned<ValueType>();
+    const size_t size = static_cast<size_t>(std::distance(std::begin(container), std::end(container)));
+    std::vector<IteratorType> chunk_first;
+    std::vector<size_t> chunk_offset;
+    const size_t chunk_count = parallel_chunks(std::begin(container), size, 1 << 14, chunk_first, chunk_offset);
+    const partition_bucket bucket_for(count);
+    std::vector<uint32_t> bucket_of(size);
+    std::vector<size_t> histograms(chunk_count * count, 0);
+    parallel_for(chunk_count, [&](size_t chunk) {
+      size_t* histogram = histograms.data() + chunk * count;
+      uint32_t* bucket = bucket_of.data() + chunk_offset[chunk];
+      for (IteratorType it = chunk_first[chunk]; it != chunk_first[chunk + 1]; ++it, ++bucket) {
+        *bucket = bucket_for(static_cast<size_t>(hash_functor(*it)));
+        ++histogram[*bucket];
+      }
+    });
+    std::vector<size_t> offsets(count + 1, 0);
+    size_t running = 0;
+    for (size_t bucket = 0; bucket < count; ++bucket) {
+      offsets[bucket] = running;
+      for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        const size_t chunk_elements = histograms[chunk * count + bucket];
+        histograms[chunk * count + bucket] = running;
+        running += chunk_elements;
+      }
+    }
+    offsets[count] = running;
+    std::vector<ValueType> elements(size);
+    parallel_for(chunk_count, [&](size_t chunk) {
+      partition_scatter(chunk_first[chunk], chunk_first[chunk + 1], bucket_of.data() + chunk_offset[chunk],
+        histograms.data() + chunk * count, count, elements.data(), UseLines());
+    });
+    return partitioned<ValueType>(std::move(elements), std::move(offsets));
+  }
+}
+CREATE_TAG_2_ARG( PartitionByTag );
+template <typename ContainerType, typename ArgType0, typename ArgType1> // hash functor, partition count
+UnderscoreDetail::partitioned<typename ContainerType::value_type>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::PartitionByTag2Arg<ArgType0, ArgType1>& tag) {
+  return UnderscoreDetail::partition_by(container, tag.arg0, static_cast<size_t>(tag.arg1));
+}
+CREATE_TAG_1_ARG( ParEachPartitionTag );
+template <typename ValueType, typename ArgType0> // functor taking a partition_range, modifies the partitions in place
+UnderscoreDetail::partitioned<ValueType>&
+PIPE_OPERATOR(UnderscoreDetail::partitioned<ValueType>& partitions, const UnderscoreTags::ParEachPartitionTag1Arg<ArgType0>& tag) {
+  UnderscoreDetail::parallel_for(partitions.partition_count(), [&](size_t idx) { tag.arg0(partitions.partition(idx)); });
+  return partitions;
+}
+template <typename ValueType, typename ArgType0> // functor taking a partition_range, r-value partitions are moved through
+UnderscoreDetail::partitioned<ValueType>
+PIPE_OPERATOR(UnderscoreDetail::partitioned<ValueType>&& partitions, const UnderscoreTags::ParEachPartitionTag1Arg<ArgType0>& tag) {
+  partitions | tag;
+  return std::move(partitions);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Strings
+//
+
+namespace UnderscoreDetail {
+  template <typename StreamType, typename StringType>
+  struct make_string_base : public StringType {
+    typedef StringType inherited;
+    template <typename T>
+    make_string_base operator<<(const T& rhs) {
+      StreamType stream;
+      stream << rhs;
+      inherited::append(stream.str());
+      return *this;
+    }
+    template <typename T>
+    make_string_base operator<<(const std::basic_string<T>& rhs) {
+      StringType str(rhs.begin(), rhs.end());
+      inherited::append(str);
+      return *this;
+    }
+  };
+  typedef make_string_base<std::stringstream, std::string> make_string;
+  typedef make_string_base<std::wstringstream, std::wstring> make_wstring;
+
+  // container_to_string
+  template <typename StringType, typename StreamType, typename ContainerType>
+  StringType
+  container_to_string(const ContainerType& container) {
+    auto first = std::begin(container);
+    const auto& last = std::end(container);
+    const auto& prev_last = std::prev(last);
+    StreamType sstr;
+    sstr << "[";
+    while(first != last) {
+      sstr << (*first);
+      if (first != prev_last)
+        sstr << ", ";
+      ++first;
+    }
+    sstr << "]";
+    return sstr.str();
+  }
+  template <typename ValueType> // is arithmetic, not a container - use std::to_string
+  std::string to_string_impl(const ValueType& value, std::true_type, std::false_type) {
+    return std::to_string(value);
   }
   template <typename ValueType> // not arithmetic, not a container - use a stream
   std::string to_string_impl(const ValueType& value, std::false_type, std::false_type) {
@@ -2253,6 +8059,28 @@ std::wstring
 PIPE_OPERATOR(const std::deque<ValueType, AllocType>& container, const UnderscoreTags::ToWstringTag&) {
   return UnderscoreDetail::container_to_string<std::wstring, std::wstringstream>(container);
 }
+/// to_string/to_wstring - small_vector
+template <typename ValueType, size_t N>
+std::string
+PIPE_OPERATOR(const UnderscoreDetail::small_vector<ValueType, N>& container, const UnderscoreTags::ToStringTag&) {
+  return UnderscoreDetail::container_to_string<std::string, std::stringstream>(container);
+}
+template <typename ValueType, size_t N>
+std::wstring
+PIPE_OPERATOR(const UnderscoreDetail::small_vector<ValueType, N>& container, const UnderscoreTags::ToWstringTag&) {
+  return UnderscoreDetail::container_to_string<std::wstring, std::wstringstream>(container);
+}
+/// to_string/to_wstring - flat_set
+template <typename ValueType, typename CompareType, typename AllocType>
+std::string
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::ToStringTag&) {
+  return UnderscoreDetail::container_to_string<std::string, std::stringstream>(container);
+}
+template <typename ValueType, typename CompareType, typename AllocType>
+std::wstring
+PIPE_OPERATOR(const UnderscoreDetail::flat_set<ValueType, CompareType, AllocType>& container, const UnderscoreTags::ToWstringTag&) {
+  return UnderscoreDetail::container_to_string<std::wstring, std::wstringstream>(container);
+}
 /// to_string/to_wstring - array
 template <typename ValueType, size_t N>
 std::string
@@ -2362,31 +8190,540 @@ operator<<(const UnderscoreTags::WstrTag&, const ValueType& value) {
 }
 
 /// tokenize_string
-CREATE_TAG_1_ARG(TokenizeStringTag);
+namespace UnderscoreTags {
+  template <typename ArgType0, typename OutContainerType>
+  struct TokenizeStringIntoTag1Arg {
+    TokenizeStringIntoTag1Arg(const ArgType0& arg0) : arg0(arg0) {}
+    TokenizeStringIntoTag1Arg& operator=(const TokenizeStringIntoTag1Arg&);
+    const ArgType0& arg0;
+  };
+  template <typename ArgType0>
+  struct TokenizeStringTag1Arg {
+    TokenizeStringTag1Arg(const ArgType0& arg0) : arg0(arg0) {}
+    TokenizeStringTag1Arg& operator=(const TokenizeStringTag1Arg&);
+    template <typename OutContainerType>
+    TokenizeStringIntoTag1Arg<ArgType0, OutContainerType> into() const {
+      return TokenizeStringIntoTag1Arg<ArgType0, OutContainerType>(arg0);
+    }
+    const ArgType0& arg0;
+  };
+  struct TokenizeStringTag {
+    TokenizeStringTag() {}
+    TokenizeStringTag& operator=(const TokenizeStringTag&);
+    IMPLEMENTS_1_ARG_OPERATOR( TokenizeStringTag )
+  };
+}
+namespace UnderscoreDetail {
+  // for_each_token - calls on_token(left, right) for every token separated by any of the delimiters
+  template <typename IteratorType, typename DelimitersType, typename TokenCallbackType>
+  void
+  for_each_token(IteratorType first, IteratorType last, const DelimitersType& delimiters, TokenCallbackType& on_token) {
+    typedef typename std::iterator_traits<IteratorType>::value_type ValueType;
+    const auto& delimiters_begin = std::begin(delimiters);
+    const auto& delimiters_end = std::find(delimiters_begin, std::end(delimiters), static_cast<ValueType>(0)); // Find null, to be compatible with char literals
+    for(auto left = find_first_not_of(first, last, delimiters_begin, delimiters_end);
+      left != last;
+      left = find_first_not_of(left, last, delimiters_begin, delimiters_end)
+      ) {
+      const auto& right = std::find_first_of(std::next(left), last, delimiters_begin, delimiters_end);
+      on_token(left, right);
+      left = right;
+    }
+  }
+  // make_token - construct from an iterator pair, or from pointer and length for view types such as std::string_view
+  template <typename TokenType, typename IteratorType>
+  TokenType make_token_impl(IteratorType first, IteratorType last, std::true_type) {
+    return TokenType(first, last);
+  }
+  template <typename TokenType, typename IteratorType>
+  TokenType make_token_impl(IteratorType first, IteratorType last, std::false_type) {
+    return TokenType(std::addressof(*first), static_cast<size_t>(std::distance(first, last)));
+  }
+  template <typename TokenType, typename IteratorType>
+  TokenType make_token(IteratorType first, IteratorType last) {
+    return make_token_impl<TokenType>(first, last, typename std::is_constructible<TokenType, IteratorType, IteratorType>::type());
+  }
+  // Token callbacks
+  template <typename ContainerType, typename TokensType>
+  struct append_token_like {
+    append_token_like(const ContainerType& source, TokensType& tokens) : source(source), tokens(tokens) {}
+    append_token_like& operator=(const append_token_like&);
+    template <typename IteratorType>
+    void operator()(IteratorType first, IteratorType last) {
+      ContainerType token = make_empty_like(source);
+      token.assign(first, last);
+      tokens.emplace_back(std::move(token));
+    }
+    const ContainerType& source;
+    TokensType& tokens;
+  };
+  template <typename TokensType>
+  struct append_token {
+    append_token(TokensType& tokens) : tokens(tokens) {}
+    append_token& operator=(const append_token&);
+    template <typename IteratorType>
+    void operator()(IteratorType first, IteratorType last) {
+      tokens.push_back(make_token<typename TokensType::value_type>(first, last));
+    }
+    TokensType& tokens;
+  };
+}
 template <typename ContainerType, typename ArgType0>
-std::vector<ContainerType>
+std::vector<ContainerType, typename UnderscoreDetail::allocator_for<ContainerType, ContainerType>::type>
 PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TokenizeStringTag1Arg<ArgType0>& tag) {
-	std::vector<ContainerType> tokens;
-	tokens.reserve(16);
-	const auto& null_character = static_cast<typename ContainerType::value_type>(0);
-	const auto& container_begin = std::begin(container);
-	const auto& container_end = std::end(container);
-	const auto& delimiters = tag.arg0;
-	const auto& delimiters_begin = std::begin(delimiters);
-	const auto& delimiters_end = std::find(delimiters_begin, std::end(delimiters), null_character); // Find null, to be compatible with char literals
-	for(auto left = UnderscoreDetail::find_first_not_of(container_begin, container_end, delimiters_begin, delimiters_end);
-		left != container_end;
-		left = UnderscoreDetail::find_first_not_of(left, container_end, delimiters_begin, delimiters_end)
-		) {
-		const auto& right = std::find_first_of(std::next(left), container_end, delimiters_begin, delimiters_end);
-		ContainerType token;
-		token.assign(left, right);
-		tokens.emplace_back(std::move(token));
-		left = right;
-  }
+  typedef UnderscoreDetail::allocator_for<ContainerType, ContainerType> AllocatorFor;
+  typedef std::vector<ContainerType, typename AllocatorFor::type> TokensType;
+  TokensType tokens(AllocatorFor::get(container));
+  tokens.reserve(16);
+  UnderscoreDetail::append_token_like<ContainerType, TokensType> on_token(container, tokens);
+  UnderscoreDetail::for_each_token(std::begin(container), std::end(container), tag.arg0, on_token);
+  return tokens;
+}
+template <typename ContainerType, typename ArgType0, typename OutContainerType>
+OutContainerType
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TokenizeStringIntoTag1Arg<ArgType0, OutContainerType>& tag) {
+  OutContainerType tokens;
+  UnderscoreDetail::append_token<OutContainerType> on_token(tokens);
+  UnderscoreDetail::for_each_token(std::begin(container), std::end(container), tag.arg0, on_token);
   return tokens;
 }
 
+/// tokenize_view
+namespace UnderscoreDetail {
+  // token_view - lazy tokenization of contiguous characters into string_ref tokens, refers to the characters
+  class token_view {
+  public:
+    class iterator {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef string_ref value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const string_ref* pointer;
+      typedef const string_ref& reference;
+      iterator() : pos_(nullptr), last_(nullptr), delimiters_(nullptr) {}
+      iterator(const char* pos, const char* last, const std::string* delimiters)
+      : pos_(pos)
+      , last_(last)
+      , delimiters_(delimiters) {
+        read();
+      }
+      reference operator*() const { return token_; }
+      pointer operator->() const { return &token_; }
+      iterator& operator++() {
+        read();
+        return *this;
+      }
+      iterator operator++(int) {
+        iterator copy = *this;
+        read();
+        return copy;
+      }
+      bool operator==(const iterator& other) const { return token_.data() == other.token_.data(); }
+      bool operator!=(const iterator& other) const { return token_.data() != other.token_.data(); }
+    private:
+      void read() {
+        const char* const delimiters_first = delimiters_->data();
+        const char* const delimiters_last = delimiters_first + delimiters_->size();
+        const char* const left = find_first_not_of(pos_, last_, delimiters_first, delimiters_last);
+        if (left == last_) {
+          token_ = string_ref();
+          pos_ = last_;
+          return;
+        }
+        pos_ = std::find_first_of(left + 1, last_, delimiters_first, delimiters_last);
+        token_ = string_ref(left, static_cast<size_t>(pos_ - left));
+      }
+      const char* pos_;
+      const char* last_;
+      const std::string* delimiters_;
+      string_ref token_;
+    };
+    typedef iterator const_iterator;
+    typedef string_ref value_type;
+    token_view(const char* first, const char* last, const std::string& delimiters)
+    : first_(first)
+    , last_(last)
+    , delimiters_(delimiters)
+    {}
+    token_view(const token_view& other)
+    : first_(other.first_)
+    , last_(other.last_)
+    , delimiters_(other.delimiters_)
+    {}
+    iterator begin() const { return iterator(first_, last_, &delimiters_); }
+    iterator end() const { return iterator(); }
+    bool empty() const { return begin() == end(); }
+  private:
+    const char* first_;
+    const char* last_;
+    std::string delimiters_;
+  };
+}
+CREATE_TAG_1_ARG( TokenizeViewTag );
+template <typename ContainerType, typename ArgType0> // contiguous characters
+UnderscoreDetail::token_view
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::TokenizeViewTag1Arg<ArgType0>& tag) {
+  const auto& delimiters_end = std::find(std::begin(tag.arg0), std::end(tag.arg0), '\0'); // Find null, to be compatible with char literals
+  const char* first = container.size() == 0 ? nullptr : std::addressof(*std::begin(container));
+  return UnderscoreDetail::token_view(first, first + container.size(), std::string(std::begin(tag.arg0), delimiters_end));
+}
+
+/// parse, try_parse, parse_each
+namespace UnderscoreDetail {
+  // char_range - the characters of a string, string_ref, string_view or null terminated literal
+  inline std::pair<const char*, const char*> char_range(const char* str) {
+    return std::make_pair(str, str + std::char_traits<char>::length(str));
+  }
+  template <size_t N>
+  std::pair<const char*, const char*> char_range(const char (&str)[N]) {
+    return std::make_pair(str, std::find(str, str + N, '\0'));
+  }
+  template <typename ContainerType>
+  std::pair<const char*, const char*> char_range(const ContainerType& text) {
+    const char* first = text.size() == 0 ? nullptr : std::addressof(*std::begin(text));
+    return std::make_pair(first, first + text.size());
+  }
+
+  // parse_number - the whole range must be the number, returns false and leaves value untouched otherwise
+  template <typename T>
+  bool parse_number(const char* first, const char* last, T& value, std::true_type /*is_integral*/) {
+    typedef typename std::make_unsigned<T>::type UnsignedType;
+    bool negative = false;
+    if (first != last && (*first == '-' || *first == '+')) {
+      negative = *first == '-';
+      if (negative && !std::is_signed<T>::value)
+        return false;
+      ++first;
+    }
+    if (first == last)
+      return false;
+    const UnsignedType limit = static_cast<UnsignedType>(static_cast<UnsignedType>(std::numeric_limits<T>::max()) + (negative ? 1 : 0));
+    UnsignedType result = 0;
+    for (; first != last; ++first) {
+      const unsigned digit = static_cast<unsigned>(*first - '0');
+      if (digit > 9 || result > static_cast<UnsignedType>((limit - digit) / 10))
+        return false;
+      result = static_cast<UnsignedType>(result * 10 + digit);
+    }
+    value = negative ? static_cast<T>(0 - result) : static_cast<T>(result);
+    return true;
+  }
+  template <typename T>
+  bool parse_float_fallback(const char* first, const char* last, T& value) {
+    if (first != last && *first == '+')
+      ++first;
+#if __cplusplus >= 201703L && defined(__cpp_lib_to_chars)
+    T result;
+    const auto& parsed = std::from_chars(first, last, result);
+    if (parsed.ec != std::errc() || parsed.ptr != last)
+      return false;
+    value = result;
+    return true;
+#else
+    const std::string copy(first, last); // strtod needs a terminating null
+    char* end = nullptr;
+    const T result = static_cast<T>(std::strtod(copy.c_str(), &end));
+    if (copy.empty() || end != copy.c_str() + copy.size())
+      return false;
+    value = result;
+    return true;
+#endif
+  }
+  // Floating point uses Clinger's fast path, a mantissa and power of ten which are both exactly
+  // representable give a correctly rounded result with a single multiplication or division.
+  // Longer mantissas, larger exponents, inf and nan go through from_chars or strtod.
+  template <typename T>
+  bool parse_number(const char* first, const char* last, T& value, std::false_type /*is_integral*/) {
+    UNDERSCORE_STATIC_ASSERT(std::is_floating_point<T>::value, "parse supports integral and floating point types");
+    static const double powers_of_ten[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const int max_exact_power = sizeof(T) == sizeof(float) ? 10 : 22;
+    const uint64_t max_exact_mantissa = static_cast<uint64_t>(1) << std::numeric_limits<T>::digits;
+    const char* const begin = first;
+    bool negative = false;
+    if (first != last && (*first == '-' || *first == '+')) {
+      negative = *first == '-';
+      ++first;
+    }
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool any_digits = false;
+    bool truncated = false;
+    for (; first != last && static_cast<unsigned>(*first - '0') <= 9; ++first) {
+      any_digits = true;
+      if (significant_digits < 19) {
+        mantissa = mantissa * 10 + static_cast<unsigned>(*first - '0');
+        significant_digits += mantissa != 0 ? 1 : 0;
+      }
+      else {
+        truncated = true;
+        ++exponent;
+      }
+    }
+    if (first != last && *first == '.') {
+      for (++first; first != last && static_cast<unsigned>(*first - '0') <= 9; ++first) {
+        any_digits = true;
+        if (significant_digits < 19) {
+          mantissa = mantissa * 10 + static_cast<unsigned>(*first - '0');
+          significant_digits += mantissa != 0 ? 1 : 0;
+          --exponent;
+        }
+        else
+          truncated = true;
+      }
+    }
+    if (!any_digits)
+      return parse_float_fallback(begin, last, value); // inf, nan or not a number
+    if (first != last && (*first == 'e' || *first == 'E')) {
+      ++first;
+      bool negative_exponent = false;
+      if (first != last && (*first == '-' || *first == '+')) {
+        negative_exponent = *first == '-';
+        ++first;
+      }
+      if (first == last)
+        return false;
+      int explicit_exponent = 0;
+      for (; first != last; ++first) {
+        const unsigned digit = static_cast<unsigned>(*first - '0');
+        if (digit > 9)
+          return false;
+        explicit_exponent = std::min(explicit_exponent * 10 + static_cast<int>(digit), 100000);
+      }
+      exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+    if (first != last)
+      return false;
+    if (truncated || mantissa > max_exact_mantissa || exponent > max_exact_power || exponent < -max_exact_power)
+      return parse_float_fallback(begin, last, value);
+    T result = static_cast<T>(mantissa);
+    if (exponent < 0)
+      result /= static_cast<T>(powers_of_ten[-exponent]);
+    else
+      result *= static_cast<T>(powers_of_ten[exponent]);
+    value = negative ? -result : result;
+    return true;
+  }
+  template <typename T>
+  bool parse_number(const char* first, const char* last, T& value) {
+    return parse_number(first, last, value, std::integral_constant<bool, std::is_integral<T>::value>());
+  }
+  inline bool parse_number(const char* first, const char* last, bool& value) {
+    unsigned char digit = 0;
+    if (!parse_number(first, last, digit, std::true_type()) || digit > 1)
+      return false;
+    value = digit != 0;
+    return true;
+  }
+}
+CREATE_TAG_TEMPLATE( ParseTag );
+template <typename ContainerType, typename ValueType> // a value initialized ValueType when the text is not a number
+ValueType
+PIPE_OPERATOR(const ContainerType& text, const UnderscoreTags::ParseTag<ValueType>&) {
+  const auto& range = UnderscoreDetail::char_range(text);
+  ValueType value = ValueType();
+  UnderscoreDetail::parse_number(range.first, range.second, value);
+  return value;
+}
+CREATE_TAG_TEMPLATE( TryParseTag );
+template <typename ContainerType, typename ValueType>
+UnderscoreDetail::optional<ValueType>
+PIPE_OPERATOR(const ContainerType& text, const UnderscoreTags::TryParseTag<ValueType>&) {
+  const auto& range = UnderscoreDetail::char_range(text);
+  ValueType value = ValueType();
+  if (!UnderscoreDetail::parse_number(range.first, range.second, value))
+    return UnderscoreDetail::optional<ValueType>();
+  return UnderscoreDetail::optional<ValueType>(value);
+}
+CREATE_TAG_TEMPLATE( ParseEachTag );
+template <typename ContainerType, typename ValueType> // container of strings
+std::vector<ValueType>
+PIPE_OPERATOR(const ContainerType& texts, const UnderscoreTags::ParseEachTag<ValueType>&) {
+  std::vector<ValueType> values;
+  values.reserve(static_cast<size_t>(std::distance(std::begin(texts), std::end(texts))));
+  for (auto it = std::begin(texts); it != std::end(texts); ++it) {
+    const auto& range = UnderscoreDetail::char_range(*it);
+    ValueType value = ValueType();
+    UnderscoreDetail::parse_number(range.first, range.second, value);
+    values.push_back(value);
+  }
+  return values;
+}
+
+/// parse_csv
+namespace UnderscoreDetail {
+  template <size_t... Indices>
+  struct index_sequence {};
+  template <size_t N, size_t... Indices>
+  struct make_index_sequence : make_index_sequence<N - 1, N - 1, Indices...> {};
+  template <size_t... Indices>
+  struct make_index_sequence<0, Indices...> {
+    typedef index_sequence<Indices...> type;
+  };
+
+  // match_mask64 - bit i is set when block[i] equals value
+  inline uint64_t match_mask64(const char* block, char value) {
+#if UNDERSCORE_SSE2
+    const __m128i needle = _mm_set1_epi8(value);
+    const uint64_t m0 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), needle)));
+    const uint64_t m1 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16)), needle)));
+    const uint64_t m2 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32)), needle)));
+    const uint64_t m3 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48)), needle)));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+#else
+    uint64_t mask = 0;
+    for (size_t i = 0; i < 64; ++i)
+      mask |= static_cast<uint64_t>(block[i] == value) << i;
+    return mask;
+#endif
+  }
+  // prefix_xor - bit i is the xor of bits 0..i, turns quote positions into a mask of the quoted bytes
+  inline uint64_t prefix_xor(uint64_t mask) {
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+  }
+
+  inline bool is_csv_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+  // csv_field - parses one field into its column, a field which does not parse gives a value initialized element
+  template <typename T>
+  void parse_csv_field(const char* first, const char* last, std::vector<T>& column, std::true_type /*is_arithmetic*/) {
+    while (first != last && (is_csv_space(*first) || *first == '"'))
+      ++first;
+    while (first != last && (is_csv_space(last[-1]) || last[-1] == '"'))
+      --last;
+    T value = T();
+    parse_number(first, last, value);
+    column.push_back(value);
+  }
+  template <typename T>
+  void parse_csv_field(const char* first, const char* last, std::vector<T>& column, std::false_type /*is_arithmetic*/) {
+    if (first != last && last[-1] == '\r')
+      --last;
+    if (first == last || *first != '"') {
+      column.push_back(make_token<T>(first, last));
+      return;
+    }
+    // Quoted, drop the quotes and turn each doubled quote into one
+    ++first;
+    if (first != last && last[-1] == '"')
+      --last;
+    std::string unquoted;
+    unquoted.reserve(static_cast<size_t>(last - first));
+    for (; first != last; ++first) {
+      unquoted.push_back(*first);
+      if (*first == '"' && std::next(first) != last && first[1] == '"')
+        ++first;
+    }
+    column.push_back(T(unquoted.begin(), unquoted.end()));
+  }
+
+  // csv_parser - splits the input into fields using 64 byte blocks of delimiter, newline and quote
+  // bitmasks, separators inside quotes are masked out with a prefix xor of the quote bits
+  template <typename... ColumnTypes>
+  class csv_parser {
+  public:
+    typedef std::tuple<std::vector<ColumnTypes>...> columns_type;
+    csv_parser(char delimiter, bool has_header)
+    : delimiter_(delimiter)
+    , skip_row_(has_header)
+    , column_(0)
+    {}
+    columns_type parse(const char* data, size_t size) {
+      uint64_t inside_quotes = 0;
+      size_t field_start = 0;
+      char padded[64];
+      for (size_t block_start = 0; block_start < size; block_start += 64) {
+        const char* block = data + block_start;
+        if (size - block_start < 64) {
+          std::memset(padded, 0, sizeof(padded));
+          std::memcpy(padded, block, size - block_start);
+          block = padded;
+        }
+        const uint64_t quoted = prefix_xor(match_mask64(block, '"')) ^ inside_quotes;
+        inside_quotes = (quoted >> 63) != 0 ? ~static_cast<uint64_t>(0) : 0;
+        const uint64_t newlines = match_mask64(block, '\n');
+        uint64_t separators = (match_mask64(block, delimiter_) | newlines) & ~quoted;
+        if (block == padded)
+          separators &= (static_cast<uint64_t>(1) << (size - block_start)) - 1;
+        for (; separators != 0; separators &= separators - 1) {
+          const size_t bit = count_trailing_zeros(separators);
+          const size_t pos = block_start + bit;
+          end_field(data + field_start, data + pos, ((newlines >> bit) & 1) != 0);
+          field_start = pos + 1;
+        }
+      }
+      if (field_start < size || column_ != 0)
+        end_field(data + field_start, data + size, true);
+      return std::move(columns_);
+    }
+  private:
+    typedef void (*field_parser)(columns_type&, const char*, const char*);
+    template <size_t Index>
+    static void parse_column(columns_type& columns, const char* first, const char* last) {
+      typedef typename std::tuple_element<Index, std::tuple<ColumnTypes...> >::type ValueType;
+      parse_csv_field(first, last, std::get<Index>(columns), std::integral_constant<bool, std::is_arithmetic<ValueType>::value>());
+    }
+    template <size_t Index>
+    static void default_column(columns_type& columns) {
+      typedef typename std::tuple_element<Index, std::tuple<ColumnTypes...> >::type ValueType;
+      std::get<Index>(columns).push_back(ValueType());
+    }
+    template <size_t... Indices>
+    void parse_field(size_t column, const char* first, const char* last, index_sequence<Indices...>) {
+      static const field_parser parsers[] = { &csv_parser::parse_column<Indices>... };
+      parsers[column](columns_, first, last);
+    }
+    template <size_t... Indices>
+    void default_field(size_t column, index_sequence<Indices...>) {
+      static void (* const defaults[])(columns_type&) = { &csv_parser::default_column<Indices>... };
+      defaults[column](columns_);
+    }
+    void end_field(const char* first, const char* last, bool end_of_row) {
+      typedef typename make_index_sequence<sizeof...(ColumnTypes)>::type indices;
+      if (skip_row_) {
+        skip_row_ = !end_of_row;
+        return;
+      }
+      if (end_of_row && column_ == 0 && (first == last || (last - first == 1 && *first == '\r')))
+        return; // blank line
+      if (column_ < sizeof...(ColumnTypes))
+        parse_field(column_, first, last, indices());
+      ++column_;
+      if (!end_of_row)
+        return;
+      for (; column_ < sizeof...(ColumnTypes); ++column_)
+        default_field(column_, indices());
+      column_ = 0;
+    }
+    const char delimiter_;
+    bool skip_row_;
+    size_t column_;
+    columns_type columns_;
+  };
+}
+namespace UnderscoreTags {
+  template <typename... ColumnTypes>
+  struct ParseCsvTag {
+    ParseCsvTag(char delimiter, bool has_header) : delimiter(delimiter), has_header(has_header) {}
+    char delimiter;
+    bool has_header;
+  };
+}
+template <typename ContainerType, typename... ColumnTypes> // contiguous characters
+std::tuple<std::vector<ColumnTypes>...>
+PIPE_OPERATOR(const ContainerType& container, const UnderscoreTags::ParseCsvTag<ColumnTypes...>& tag) {
+  UNDERSCORE_STATIC_ASSERT(sizeof...(ColumnTypes) > 0, "parse_csv requires at least one column");
+  const char* data = container.size() == 0 ? nullptr : std::addressof(*std::begin(container));
+  return UnderscoreDetail::csv_parser<ColumnTypes...>(tag.delimiter, tag.has_header).parse(data, container.size());
+}
+
 /// to_lower
 CREATE_TAG_0_ARG( ToLowerTag );
 template<typename ContainerType>
@@ -2434,6 +8771,7 @@ struct Underscore {
   UnderscoreTags::CBeginTag cbegin;
   UnderscoreTags::CEndTag cend;
   UnderscoreTags::CopyIfTag copy_if;
+  UnderscoreTags::ParCopyIfTag par_copy_if;
   UnderscoreTags::CountTag count;
   UnderscoreTags::CountIfTag count_if;
   UnderscoreTags::EndTag end;
@@ -2459,6 +8797,7 @@ struct Underscore {
   UnderscoreTags::GetTag<5> get_5, sixth;
   UnderscoreTags::GetTag<6> get_6, seventh;
   UnderscoreTags::HashTag hash;
+  UnderscoreTags::HashCombineTag hash_combine;
   UnderscoreTags::InserterTag inserter;
   UnderscoreTags::IsSortedTag is_sorted;
   UnderscoreTags::MeanValueTag mean_value;
@@ -2478,6 +8817,10 @@ struct Underscore {
   UnderscoreTags::LexicographicalCompareTag lexicographical_compare; //
   UnderscoreTags::LowerBoundTag lower_bound; //
   UnderscoreTags::UpperBoundTag upper_bound; //
+  UnderscoreTags::LowerBoundBatchTag lower_bound_batch;
+  UnderscoreTags::InterpolationSearchTag interpolation_search;
+  UnderscoreTags::ExponentialSearchTag exponential_search;
+  UnderscoreTags::ToEytzingerTag to_eytzinger;
 
   // STL extensions
   UnderscoreTags::FillTag fill;
@@ -2496,6 +8839,11 @@ struct Underscore {
   UnderscoreTags::StableSortTag stable_sort;
   UnderscoreTags::TransformTag transform;
   UnderscoreTags::TransformToTag transform_to;
+  UnderscoreTags::TransformIntoTag transform_into;
+  UnderscoreTags::TransformInplaceTag transform_inplace;
+  UnderscoreTags::ParTransformTag par_transform;
+  UnderscoreTags::ParTransformIntoTag par_transform_into;
+  UnderscoreTags::ParTransformInplaceTag par_transform_inplace;
   UnderscoreTags::UniqueTag unique;
 
   // Underscore immutable tags
@@ -2530,6 +8878,68 @@ struct Underscore {
   UnderscoreTags::ToDequeTag to_deque;
   UnderscoreTags::ToSetTag to_set;
   UnderscoreTags::ToUnorderedSetTag to_unordered_set;
+  template <size_t N> UnderscoreTags::ToSmallVectorTag<N> to_small_vector() const { return UnderscoreTags::ToSmallVectorTag<N>(); }
+  template <typename T, size_t N> using small_vector = UnderscoreDetail::small_vector<T, N>;
+  UnderscoreTags::ToFlatSetTag to_flat_set;
+  UnderscoreTags::ToFlatMapTag to_flat_map;
+  UnderscoreTags::ToHashSetTag to_hash_set;
+  UnderscoreTags::ToHashMapTag to_hash_map;
+  UnderscoreTags::ToBloomFilterTag to_bloom_filter;
+  UnderscoreTags::ToCuckooFilterTag to_cuckoo_filter;
+  UnderscoreTags::MaybeContainsTag maybe_contains;
+  UnderscoreTags::MaybeContainsEachTag maybe_contains_each;
+  UnderscoreTags::SetUnionTag set_union;
+  UnderscoreTags::SetIntersectionTag set_intersection;
+  UnderscoreTags::SetDifferenceTag set_difference;
+  UnderscoreTags::SetSymmetricDifferenceTag set_symmetric_difference;
+  UnderscoreTags::MergeTag merge;
+  UnderscoreTags::MergeAllTag merge_all;
+  UnderscoreTags::ParMergeAllTag par_merge_all;
+  UnderscoreTags::ExternalSortTag external_sort;
+  UnderscoreTags::GroupByTag group_by;
+  UnderscoreTags::AggregateByTag aggregate_by;
+  UnderscoreTags::ParAggregateByTag par_aggregate_by;
+  UnderscoreTags::PartitionByTag partition_by;
+  UnderscoreTags::ParEachPartitionTag par_each_partition;
+  UnderscoreTags::InclusiveScanTag inclusive_scan;
+  UnderscoreTags::ExclusiveScanTag exclusive_scan;
+  UnderscoreTags::TransformScanTag transform_scan;
+  UnderscoreTags::ParInclusiveScanTag par_inclusive_scan;
+  UnderscoreTags::ParExclusiveScanTag par_exclusive_scan;
+  UnderscoreTags::ParTransformScanTag par_transform_scan;
+  typedef UnderscoreDetail::join_kind join_kind;
+  typedef UnderscoreDetail::run_compression run_compression;
+  UnderscoreTags::HashJoinTag hash_join;
+  UnderscoreTags::MergeJoinTag merge_join;
+  template <typename T> UnderscoreDetail::binary_record_range<T> binary_records(std::istream& stream) const { return UnderscoreDetail::binary_record_range<T>(stream); }
+  typedef UnderscoreDetail::mmap_advice mmap_advice;
+  template <typename T>
+  UnderscoreDetail::mapped_file<T, false> mmap_file(const std::string& path, mmap_advice advice = mmap_advice::normal) const {
+    return UnderscoreDetail::mapped_file<T, false>(path, advice);
+  }
+  template <typename T>
+  UnderscoreDetail::mapped_file<T, true> mmap_file_mut(const std::string& path, mmap_advice advice = mmap_advice::normal) const {
+    return UnderscoreDetail::mapped_file<T, true>(path, advice);
+  }
+  UnderscoreDetail::async_chunk_range async_chunks(const std::string& path, size_t chunk_bytes = 4 << 20, size_t in_flight = 4) const {
+    return UnderscoreDetail::async_chunk_range(std::make_shared<UnderscoreDetail::async_chunk_reader>(path, chunk_bytes, in_flight));
+  }
+  typedef UnderscoreDetail::serial_format serial_format;
+  UnderscoreTags::SerializeTag serialize;
+  template <typename T> UnderscoreTags::DeserializeTag<T> deserialize() const { return UnderscoreTags::DeserializeTag<T>(); }
+  template <typename T> UnderscoreTags::TryDeserializeTag<T> try_deserialize() const { return UnderscoreTags::TryDeserializeTag<T>(); }
+  template <typename T> UnderscoreTags::DeserializeViewTag<T> deserialize_view() const { return UnderscoreTags::DeserializeViewTag<T>(); }
+  UnderscoreTags::DeltaEncodeTag delta_encode;
+  UnderscoreTags::DeltaDecodeTag delta_decode;
+  UnderscoreTags::ZigzagTag zigzag;
+  UnderscoreTags::UnzigzagTag unzigzag;
+  UnderscoreTags::VarintEncodeTag varint_encode;
+  template <typename T> UnderscoreTags::VarintDecodeTag<T> varint_decode() const { return UnderscoreTags::VarintDecodeTag<T>(); }
+  UnderscoreTags::BitpackTag bitpack;
+  UnderscoreTags::Lz4CompressTag lz4_compress;
+  UnderscoreTags::Lz4DecompressTag lz4_decompress;
+  UnderscoreTags::WithAllocatorTag with_allocator;
+  UnderscoreDetail::monotonic_arena arena(size_t initial_bytes) const { return UnderscoreDetail::monotonic_arena(initial_bytes); }
   template <typename T> UnderscoreTags::ToContainerTag<T> to_container() const { return UnderscoreTags::ToContainerTag<T>(); }
   UnderscoreTags::MutateTag mutate;
   UnderscoreTags::PipeTag pipe;
@@ -2539,10 +8949,28 @@ struct Underscore {
   UnderscoreTags::ToLowerTag to_lower;
   UnderscoreTags::ToUpperTag to_upper;
   UnderscoreTags::TokenizeStringTag tokenize_string;
+  template <typename T> UnderscoreTags::ParseTag<T> parse() const { return UnderscoreTags::ParseTag<T>(); }
+  template <typename T> UnderscoreTags::TryParseTag<T> try_parse() const { return UnderscoreTags::TryParseTag<T>(); }
+  template <typename T> UnderscoreTags::ParseEachTag<T> parse_each() const { return UnderscoreTags::ParseEachTag<T>(); }
+  template <typename... ColumnTypes>
+  UnderscoreTags::ParseCsvTag<ColumnTypes...> parse_csv(char delimiter = ',', bool has_header = false) const { return UnderscoreTags::ParseCsvTag<ColumnTypes...>(delimiter, has_header); }
+  UnderscoreDetail::line_range lines(const std::string& path, size_t buffer_bytes = 1 << 20) const {
+    return UnderscoreDetail::line_range(std::make_shared<UnderscoreDetail::line_reader>(path, buffer_bytes));
+  }
+  UnderscoreDetail::line_range lines(std::istream& stream, size_t buffer_bytes = 1 << 20) const {
+    return UnderscoreDetail::line_range(std::make_shared<UnderscoreDetail::line_reader>(stream, buffer_bytes));
+  }
   
   // Views
   //UnderscoreTags::SubViewTag sub_view;
+  UnderscoreTags::SetUnionViewTag set_union_view;
+  UnderscoreTags::SetIntersectionViewTag set_intersection_view;
+  UnderscoreTags::SetDifferenceViewTag set_difference_view;
+  UnderscoreTags::SetSymmetricDifferenceViewTag set_symmetric_difference_view;
+  UnderscoreTags::MergeAllViewTag merge_all_view;
   //UnderscoreTags::WhereTag where;
+  UnderscoreTags::FilterViewTag filter_view;
+  UnderscoreTags::TokenizeViewTag tokenize_view;
 
   // Access tags
   UnderscoreTags::AtTag at;
@@ -32,6 +32,21 @@ namespace UTDetail {
     });
     return floats;
   }
+  // Allocator which counts the number of allocations made through it
+  template <typename T>
+  struct CountingAllocator {
+    typedef T value_type;
+    explicit CountingAllocator(size_t* counter) : counter(counter) {}
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : counter(other.counter) {}
+    T* allocate(size_t n) { ++(*counter); return std::allocator<T>().allocate(n); }
+    void deallocate(T* ptr, size_t n) { std::allocator<T>().deallocate(ptr, n); }
+    size_t* counter;
+  };
+  template <typename T, typename U>
+  bool operator==(const CountingAllocator<T>& a, const CountingAllocator<U>& b) { return a.counter == b.counter; }
+  template <typename T, typename U>
+  bool operator!=(const CountingAllocator<T>& a, const CountingAllocator<U>& b) { return a.counter != b.counter; }
 }
 
 
@@ -167,6 +182,13 @@ void run_underscore_test() {
     TEST( 1.0 | _.reinterval(0.0, 10.0, 0.0, 100.0) , 10.0 );
     TEST( 0.6 | _.round, 1.0);
     TEST( 1.49 | _.round, 1.0);
+    TEST( -2.5 | _.abs, 2.5 );
+    TEST( -2.5f | _.abs, 2.5f );
+    TEST( -3 | _.abs, 3 );
+    TEST( -1.0 | _.clamp(0.0, 1.0), 0.0 );
+    TEST( 2.0 | _.clamp(0.0, 1.0), 1.0 );
+    TEST( 0.5 | _.clamp(0.0, 1.0), 0.5 );
+    TEST( std::nan("") | _.clamp(0.0, 1.0), 0.0 );
 		TEST( 100.0 | _.sin | _.cos | _.tan| _.asin | _.acos | _.atan | _.sinh | _.cosh | _.tanh | _.abs| _.fabs | _.ceil | _.floor | _.round | _.clamp(0.0, 0.0), 0.0);
   }
   
@@ -187,6 +209,737 @@ void run_underscore_test() {
     //TEST(array | _.transform_to( functor, std::vector<float>() ), vec_transform );
   }
   
+  // allocators
+  {
+    size_t num_allocations = 0;
+    const UTDetail::CountingAllocator<int> allocator(&num_allocations);
+    const auto& counted = array | _.with_allocator(allocator);
+    TEST( num_allocations, 1 );
+    TEST( counted | _.sort | _.erase_all(4) | _.to_deque | _.size, 4 );
+    const size_t after_pipes = num_allocations;
+    TEST( after_pipes > 1, true );
+    const auto& squared = counted | _.transform([](int x) { return (float)(x*x); });
+    TEST( squared.get_allocator().counter, &num_allocations );
+    TEST( num_allocations, after_pipes + 1 );
+    TEST( (counted | _.to_set).get_allocator().counter, &num_allocations );
+    TEST( (counted | _.copy_if([](int x) { return x > 4; })).size(), 3 );
+    TEST( (counted | _.copy_if([](int x) { return x > 4; })).get_allocator().counter, &num_allocations );
+    const auto& tokens = std::string("a b c") | _.with_allocator(UTDetail::CountingAllocator<char>(&num_allocations)) | _.tokenize_string(" ");
+    TEST( tokens.size(), 3 );
+    TEST( tokens.get_allocator().counter, &num_allocations );
+    TEST( tokens.front().get_allocator().counter, &num_allocations );
+  }
+
+  // arena
+  {
+    auto arena = _.arena(1024);
+    const auto& sorted = vector | arena | _.sort | _.erase_all(4);
+    TEST( sorted, _.array(3,5,6,7) | _.to_vector | arena );
+    TEST( sorted.get_allocator().arena, &arena );
+    TEST( (sorted | _.transform([](int x) { return x * 0.5; })).get_allocator().arena, &arena );
+    const auto& tokens = std::string("  a bb ccc ") | arena | _.tokenize_string(" ");
+    TEST( tokens.size(), 3 );
+    TEST( tokens.back().get_allocator().arena, &arena );
+    TEST( arena.bytes_used() > 0, true );
+  }
+
+  // small_vector
+  {
+    typedef Underscore::small_vector<int, 4> SmallVector;
+    SmallVector small = array | _.to_small_vector<4>();
+    TEST( small.size(), 6 );
+    TEST( small.is_inline(), false );
+    TEST( small | _.sort | _.erase_all(4) | _.to_string, std::string("[3, 5, 6, 7]") );
+    TEST( SmallVector(small.begin(), small.begin() + 4).is_inline(), true );
+    _[small] | _.sort;
+    TEST( small | _.is_sorted, true );
+    TEST( small | _.min_value, 3 );
+    small.insert(small.begin() + 1, 3, 9);
+    TEST( small | _.to_vector, _.array(3,9,9,9,4,4,5,6,7) | _.to_vector );
+    small.erase(small.begin(), small.begin() + 4);
+    TEST( small | _.to_vector, _.array(4,4,5,6,7) | _.to_vector );
+  }
+
+  // flat_set, flat_map
+  {
+    const auto& set = vector | _.to_flat_set;
+    TEST( set | _.to_string, std::string("[3, 4, 5, 6, 7]") );
+    TEST( set | _.contains(6), true );
+    TEST( set | _.contains(8), false );
+    TEST( set | _.find(5) | _.deref, 5 );
+    TEST( (set | _.find(2)) == set.end(), true );
+    TEST( set | _.lower_bound(5) | _.deref, 5 );
+    TEST( set | _.upper_bound(5) | _.deref, 6 );
+    TEST( set | _.binary_search(3), true );
+    TEST( set | _.includes(_.array(7,3,5)), true );
+    TEST( set | _.includes(_.array(7,3,8)), false );
+    TEST( set | _.includes(_.array(3,4) | _.to_flat_set), true );
+    const auto& squares = set | _.to_flat_map([](int x) { return x; }, [](int x) { return x * x; });
+    TEST( squares.size(), 5 );
+    TEST( squares | _.find(6) | _.deref | _.second, 36 );
+    TEST( squares | _.contains(7), true );
+    TEST( squares | _.value_or_default(8, 0), 0 );
+    TEST( squares | _.value_or_default(4, 0), 16 );
+    std::vector<std::pair<std::string, int> > pairs;
+    pairs.push_back(std::make_pair("b", 1));
+    pairs.push_back(std::make_pair("a", 2));
+    pairs.push_back(std::make_pair("b", 3));
+    const auto& by_name = pairs | _.to_flat_map;
+    TEST( by_name.size(), 2 );
+    TEST( by_name.begin()->first, std::string("a") );
+    TEST( by_name.at("b"), 1 );
+  }
+
+  // hash_set, hash_map
+  {
+    const auto& set = vector | _.to_hash_set;
+    TEST( set.size(), 5 );
+    TEST( set | _.contains(6), true );
+    TEST( set | _.contains(8), false );
+    TEST( set | _.find(5) | _.deref, 5 );
+    TEST( (set | _.find(2)) == set.end(), true );
+    TEST( set | _.to_vector | _.sort, std::vector<int>({3, 4, 5, 6, 7}) );
+    std::vector<int> range(1000);
+    std::iota(range.begin(), range.end(), 0);
+    auto numbers = range | _.to_hash_set;
+    TEST( numbers.size(), 1000 );
+    TEST( numbers.erase(500), 1 );
+    TEST( numbers.erase(500), 0 );
+    TEST( numbers | _.contains(500), false );
+    TEST( numbers | _.contains(999), true );
+    numbers.insert(500);
+    TEST( numbers.size(), 1000 );
+    const auto& names = std::vector<std::string>({"a", "bb", "ccc"});
+    const auto& lengths = names | _.to_hash_map([](const std::string& s) { return s; }, [](const std::string& s) { return s.size(); });
+    TEST( lengths | _.find("bb") | _.deref | _.second, 2 );
+    TEST( lengths | _.contains("ccc"), true );
+    TEST( lengths | _.value_or_default("dddd", 0), 0 );
+    TEST( lengths | _.value_or_default("a", 0), 1 );
+    auto counts = std::map<std::string, int>({{"x", 1}, {"y", 2}}) | _.to_hash_map;
+    counts["x"] += 10;
+    counts["z"] = 3;
+    TEST( counts.size(), 3 );
+    TEST( counts.at("x"), 11 );
+    // Single-pass input is inserted without being counted first
+    std::istringstream words("3 1 4 1 5");
+    const UnderscoreDetail::hash_set<int> streamed((std::istream_iterator<int>(words)), std::istream_iterator<int>());
+    TEST( streamed.size(), 4 );
+    std::stringstream records;
+    const std::vector<int> values = {2, 7, 2, 9};
+    std::copy(values.begin(), values.end(), UnderscoreDetail::binary_record_writer<int>(records));
+    TEST( (_.binary_records<int>(records) | _.to_hash_set).size(), 3 );
+  }
+
+  // set algebra
+  {
+    const auto& a = std::vector<int>({1, 2, 2, 4, 6});
+    const auto& b = std::vector<int>({2, 3, 4, 4});
+    TEST( a | _.set_union(b), std::vector<int>({1, 2, 2, 3, 4, 4, 6}) );
+    TEST( a | _.set_intersection(b), std::vector<int>({2, 4}) );
+    TEST( a | _.set_difference(b), std::vector<int>({1, 2, 6}) );
+    TEST( a | _.set_symmetric_difference(b), std::vector<int>({1, 2, 3, 4, 6}) );
+    TEST( a | _.set_union_view(b) | _.to_vector, a | _.set_union(b) );
+    TEST( a | _.set_intersection_view(b) | _.to_vector, a | _.set_intersection(b) );
+    TEST( a | _.set_difference_view(b) | _.to_vector, a | _.set_difference(b) );
+    TEST( a | _.set_symmetric_difference_view(b) | _.to_vector, a | _.set_symmetric_difference(b) );
+    TEST( a | _.set_intersection_view(std::vector<int>()) | _.empty, true );
+    TEST( std::set<int>({1, 3, 5}) | _.set_intersection(std::list<int>({3, 4, 5})), std::vector<int>({3, 5}) );
+    // skewed sizes gallop through the larger range
+    std::vector<int> large(1000);
+    std::iota(large.begin(), large.end(), 0);
+    const auto& small = std::vector<int>({-1, 5, 500, 500, 998, 2000});
+    TEST( large | _.set_intersection(small), std::vector<int>({5, 500, 998}) );
+    TEST( small | _.set_intersection(large), std::vector<int>({5, 500, 998}) );
+    TEST( small | _.set_difference(large), std::vector<int>({-1, 500, 2000}) );
+    TEST( large | _.set_difference(small) | _.size, 997 );
+    TEST( large | _.set_union(small), large | _.set_union_view(small) | _.to_vector );
+    TEST( small | _.set_union(large), small | _.set_union_view(large) | _.to_vector );
+    TEST( large | _.set_symmetric_difference(small), large | _.set_symmetric_difference_view(small) | _.to_vector );
+    // flat sets stay flat sets, 32 bit integers intersect with SIMD
+    std::vector<int> evens(100);
+    std::vector<int> threes(100);
+    for (int i = 0; i < 100; ++i) {
+      evens[i] = i * 2;
+      threes[i] = i * 3;
+    }
+    const auto& sixes = (evens | _.to_flat_set) | _.set_intersection(threes | _.to_flat_set);
+    TEST( sixes.size(), 34 );
+    TEST( sixes.back(), 198 );
+    TEST( sixes.elements(), evens | _.set_intersection(threes) );
+    TEST( (evens | _.to_flat_set) | _.set_union(threes | _.to_flat_set) | _.size, 166 );
+  }
+
+  // merge
+  {
+    TEST( std::vector<int>({1, 4, 9}) | _.merge(std::list<int>({2, 4, 10})), std::vector<int>({1, 2, 4, 4, 9, 10}) );
+    std::vector<std::vector<int> > shards(7);
+    for (int i = 0; i < 7000; ++i)
+      shards[(i * 31) % 7].push_back(i / 3);
+    std::vector<int> all;
+    for (const auto& shard : shards)
+      all.insert(all.end(), shard.begin(), shard.end());
+    std::sort(all.begin(), all.end());
+    TEST( shards | _.merge_all, all );
+    TEST( shards | _.merge_all_view | _.to_vector, all );
+    TEST( shards | _.par_merge_all, all );
+    TEST( std::vector<std::vector<int> >() | _.merge_all | _.empty, true );
+    TEST( std::vector<std::vector<int> >(3) | _.merge_all_view | _.empty, true );
+    TEST( std::vector<std::vector<int> >(3) | _.par_merge_all | _.empty, true );
+  }
+
+  // external_sort
+  {
+    std::vector<int> values(10000);
+    for (size_t i = 0; i < values.size(); ++i)
+      values[i] = static_cast<int>((i * 7919) % 10007);
+    const auto& sorted = values | _.sort;
+    TEST( values | _.external_sort(1 << 20, "."), sorted ); // fits in memory
+    TEST( values | _.external_sort(4096, "."), sorted ); // ten runs on disk
+    std::stringstream binary;
+    TEST( values | _.external_sort(4096, ".", binary), values.size() );
+    TEST( _.binary_records<int>(binary) | _.to_vector, sorted );
+    std::stringstream roundtrip;
+    std::copy(values.begin(), values.end(), UnderscoreDetail::binary_record_writer<int>(roundtrip));
+    TEST( _.binary_records<int>(roundtrip) | _.external_sort(4096, "."), sorted );
+    TEST( values | _.external_sort(128, "."), sorted ); // 313 runs, merged 64 at a time before the final merge
+    TEST( values | _.external_sort(4096, ".", Underscore::run_compression::lz4), sorted );
+    TEST( values | _.external_sort(128, ".", Underscore::run_compression::lz4), sorted );
+    std::stringstream compressed;
+    TEST( values | _.external_sort(4096, ".", compressed, Underscore::run_compression::lz4), values.size() );
+    TEST( _.binary_records<int>(compressed) | _.to_vector, sorted );
+    TEST( values | _.external_sort(4096, "./no_such_dir") | _.size, 0u ); // runs can't be written
+    std::stringstream failed;
+    TEST( values | _.external_sort(4096, "./no_such_dir", failed), 0u );
+    TEST( failed.fail(), true );
+  }
+
+  // mmap_file
+  {
+    const char* path = "underscore_mmap_test.bin";
+    {
+      std::ofstream file(path, std::ios::binary);
+      for (int i = 0; i < 1000; ++i)
+        file.write(reinterpret_cast<const char*>(&i), sizeof(i));
+    }
+    {
+      const auto& numbers = _.mmap_file<int>(path, Underscore::mmap_advice::sequential);
+      TEST( numbers.is_open(), true );
+      TEST( numbers.size(), 1000 );
+      TEST( numbers | _.accumulate(0), 499500 );
+      TEST( numbers | _.count(7), 1 );
+      TEST( numbers | _.find(500) | _.deref, 500 );
+      TEST( numbers | _.max_value, 999 );
+    }
+    {
+      auto numbers = _.mmap_file_mut<int>(path, Underscore::mmap_advice::random);
+      _[numbers] | _.reverse;
+      numbers.flush();
+    }
+    TEST( _.mmap_file<int>(path).front(), 999 );
+    TEST( _.mmap_file<int>(path) | _.is_sorted, false );
+    std::remove(path);
+    TEST( _.mmap_file<int>(path).is_open(), false );
+    TEST( _.mmap_file<int>(path) | _.empty, true );
+  }
+
+  // lines, filter_view, tokenize_view
+  {
+    std::stringstream log;
+    log << "GET /index 200\r\nPOST /login 403\n\nGET /missing 404\nGET /long";
+    for (int i = 0; i < 100; ++i)
+      log << "/segment";
+    log << " 200";
+    std::vector<std::string> lines;
+    for (const auto& line : _.lines(log, 64)) // a line longer than the buffer grows it
+      lines.push_back(line);
+    TEST( lines.size(), 5 );
+    TEST( lines[0], std::string("GET /index 200") );
+    TEST( lines[2], std::string() );
+    TEST( lines[4].size(), 813 );
+    const auto& is_get = [](const UnderscoreDetail::string_ref& line) { return line.size() > 3 && line.substr(0, 3) == "GET"; };
+    std::stringstream log2(log.str());
+    TEST( _.lines(log2) | _.filter_view(is_get) | _.count_if([](const UnderscoreDetail::string_ref& line) { return line.back() == '0'; }), 2 );
+    std::stringstream log3(log.str());
+    TEST( _.lines(log3) | _.transform([](const UnderscoreDetail::string_ref& line) { return line.size(); }), std::vector<size_t>({14, 15, 0, 16, 813}) );
+    TEST( lines[1] | _.tokenize_view(" /") | _.transform([](const UnderscoreDetail::string_ref& token) { return token.str(); }), std::vector<std::string>({"POST", "login", "403"}) );
+    TEST( std::string("  ") | _.tokenize_view(" ") | _.empty, true );
+    TEST( _.lines("underscore_missing_file.txt").is_open(), false );
+    TEST( _.lines("underscore_missing_file.txt") | _.filter_view(is_get) | _.empty, true );
+    TEST( std::vector<int>({1, 2, 3, 4}) | _.filter_view([](int x) { return x % 2 == 0; }) | _.to_vector, std::vector<int>({2, 4}) );
+  }
+
+  // async_chunks
+  {
+    const char* path = "underscore_chunks_test.txt";
+    std::string content;
+    for (int i = 0; i < 5000; ++i)
+      content += std::to_string(i) + "\n";
+    {
+      std::ofstream file(path, std::ios::binary);
+      file << content;
+    }
+    std::string joined;
+    size_t chunk_count = 0;
+    for (const auto& chunk : _.async_chunks(path, 1000, 3)) {
+      joined.append(chunk.data(), chunk.size());
+      ++chunk_count;
+    }
+    TEST( joined, content );
+    TEST( chunk_count, (content.size() + 999) / 1000 );
+    TEST( _.async_chunks(path, 1 << 20) | _.transform([](const UnderscoreDetail::string_ref& chunk) { return std::count(chunk.begin(), chunk.end(), '\n'); }) | _.accumulate(0), 5000 );
+    { // stop early, the reader threads are joined on destruction
+      const auto& chunks = _.async_chunks(path, 100, 4);
+      TEST( chunks.begin()->size(), 100 );
+    }
+    std::remove(path);
+    TEST( _.async_chunks(path).is_open(), false );
+    TEST( _.async_chunks(path) | _.empty, true );
+  }
+
+  // parse_csv
+  {
+    const std::string csv =
+      "id,price,name\r\n"
+      "1,2.5,apple\r\n"
+      "2, 10 ,\"pear, green\"\n"
+      "\n"
+      "3,-0.25,\"say \"\"hi\"\"\"\n"
+      "4\n"
+      "5,1e3,\"multi\nline\",ignored";
+    const auto& columns = csv | _.parse_csv<int, double, std::string>(',', true);
+    TEST( std::get<0>(columns), std::vector<int>({1, 2, 3, 4, 5}) );
+    TEST( std::get<1>(columns), std::vector<double>({2.5, 10.0, -0.25, 0.0, 1000.0}) );
+    TEST( std::get<2>(columns), std::vector<std::string>({"apple", "pear, green", "say \"hi\"", "", "multi\nline"}) );
+    std::string tsv;
+    for (int i = 0; i < 1000; ++i)
+      tsv += std::to_string(i) + "\t" + std::to_string(i * 2) + "\n";
+    const auto& numbers = tsv | _.parse_csv<unsigned, long long>('\t');
+    TEST( std::get<0>(numbers).size(), 1000 );
+    TEST( std::get<1>(numbers) | _.accumulate(0LL), 999000LL );
+    TEST( std::get<0>(std::string() | _.parse_csv<int>()).empty(), true );
+  }
+
+  // parse
+  {
+    TEST( (std::string("-1234") | _.parse<int>()), -1234 );
+    TEST( ("+42" | _.parse<unsigned>()), 42u );
+    TEST( (std::string("3.25") | _.parse<double>()), 3.25 );
+    TEST( (std::string("-1.5e3") | _.parse<float>()), -1500.0f );
+    TEST( (std::string("12x") | _.parse<int>()), 0 );
+    TEST( (std::string("0.1") | _.parse<double>()), 0.1 );
+    TEST( (std::string("2.2250738585072014e-308") | _.parse<double>()), 2.2250738585072014e-308 );
+    TEST( (std::string("3.14159265358979323846264338327950288") | _.parse<double>()), 3.14159265358979323846 );
+    TEST( (std::string("-9223372036854775808") | _.parse<long long>()), std::numeric_limits<long long>::min() );
+    TEST( (std::string("128") | _.try_parse<signed char>()).has_value(), false );
+    TEST( (std::string("-128") | _.try_parse<signed char>()).value(), -128 );
+    TEST( (std::string("-1") | _.try_parse<unsigned>()).has_value(), false );
+    TEST( (std::string("") | _.try_parse<int>()).has_value(), false );
+    TEST( (std::string("1e") | _.try_parse<double>()).has_value(), false );
+    TEST( (std::string("7e1") | _.try_parse<double>()).value(), 70.0 );
+    const std::vector<std::string> texts = {"1", "22", "oops", "-4"};
+    TEST( (texts | _.parse_each<int>()), std::vector<int>({1, 22, 0, -4}) );
+    const std::string row = "5 -6 7";
+    TEST( (row | _.tokenize_view(" ") | _.parse_each<int>()), std::vector<int>({5, -6, 7}) );
+  }
+  // serialize
+  {
+    typedef std::tuple<std::string, std::vector<double>, std::map<int, std::list<std::string> > > Checkpoint;
+    std::map<int, std::list<std::string> > index;
+    index[3] = {"c", "cc"};
+    index[-7] = {};
+    const Checkpoint checkpoint(std::string("run 42"), std::vector<double>({0.5, -1.25, 1e300}), index);
+    const std::vector<char> bytes = checkpoint | _.serialize;
+    TEST( (bytes | _.deserialize<Checkpoint>()) == checkpoint, true );
+    const std::vector<char> compact = checkpoint | _.serialize(Underscore::serial_format::varint);
+    TEST( (compact | _.deserialize<Checkpoint>()) == checkpoint, true );
+    const std::vector<int64_t> small_ints = {0, 1, -1, 63, -64, 300, std::numeric_limits<int64_t>::min()};
+    const std::vector<char> varints = small_ints | _.serialize(Underscore::serial_format::varint);
+    TEST( (varints | _.deserialize<std::vector<int64_t> >()), small_ints );
+    TEST( varints.size() < (small_ints | _.serialize).size(), true );
+    TEST( (std::set<std::string>({"b", "a"}) | _.serialize | _.deserialize<std::set<std::string> >()) == std::set<std::string>({"a", "b"}), true );
+    TEST( (std::make_pair(true, 'x') | _.serialize | _.deserialize<std::pair<bool, char> >()) == std::make_pair(true, 'x'), true );
+    const std::array<uint16_t, 3> triple = {{1, 2, 65535}};
+    TEST( (triple | _.serialize | _.deserialize<std::array<uint16_t, 3> >()) == triple, true );
+    // Malformed input
+    TEST( (std::string("US") | _.try_deserialize<int>()).has_value(), false );
+    std::vector<char> truncated = bytes;
+    truncated.pop_back();
+    TEST( (truncated | _.try_deserialize<Checkpoint>()).has_value(), false );
+    TEST( (bytes | _.try_deserialize<Checkpoint>()).has_value(), true );
+    // Zero copy views
+    typedef std::vector<std::pair<std::string, std::vector<float> > > Embeddings;
+    const Embeddings embeddings = {{"x", {1.0f, 2.0f}}, {"yz", {}}, {"w", {-3.5f}}};
+    const std::vector<char> embedding_bytes = embeddings | _.serialize;
+    const auto& views = embedding_bytes | _.deserialize_view<Embeddings>();
+    TEST( views.size(), 3u );
+    TEST( views[1].first.str(), "yz" );
+    TEST( std::vector<float>(views[0].second.begin(), views[0].second.end()), std::vector<float>({1.0f, 2.0f}) );
+    TEST( views[2].second.back(), -3.5f );
+    TEST( views[0].second.data() >= static_cast<const void*>(embedding_bytes.data()), true );
+    const std::string path = "underscore_serialize_test.bin";
+    {
+      std::ofstream file(path.c_str(), std::ios::binary);
+      file.write(embedding_bytes.data(), static_cast<std::streamsize>(embedding_bytes.size()));
+    }
+    {
+      const auto& mapped = _.mmap_file<char>(path);
+      const auto& mapped_views = mapped | _.deserialize_view<Embeddings>();
+      TEST( mapped_views.size(), 3u );
+      TEST( mapped_views[2].second.size(), 1u );
+      TEST( (mapped | _.deserialize<Embeddings>()) == embeddings, true );
+    }
+    std::remove(path.c_str());
+  }
+  // delta_encode, zigzag, varint_encode, bitpack, lz4_compress
+  {
+    const std::vector<int> ids = {3, 7, 8, 20, 20, 1000};
+    TEST( (ids | _.delta_encode), std::vector<int>({3, 4, 1, 12, 0, 980}) );
+    TEST( (ids | _.delta_encode | _.delta_decode), ids );
+    TEST( (std::vector<int8_t>({0, -1, 1, -128, 127}) | _.zigzag), std::vector<uint8_t>({0, 1, 2, 255, 254}) );
+    TEST( (std::vector<int>({-5, 5, 0}) | _.zigzag | _.unzigzag), std::vector<int>({-5, 5, 0}) );
+    const std::vector<char> varints = ids | _.delta_encode | _.varint_encode;
+    TEST( varints.size(), 7u );
+    TEST( (varints | _.varint_decode<int>() | _.delta_decode), ids );
+    TEST( (std::vector<int64_t>({-1, std::numeric_limits<int64_t>::min()}) | _.varint_encode | _.varint_decode<int64_t>()), std::vector<int64_t>({-1, std::numeric_limits<int64_t>::min()}) );
+    TEST( (std::string("\x05\x80") | _.varint_decode<unsigned>()), std::vector<unsigned>({5}) ); // truncated, decoded up to the bad varint
+    // Bit packing
+    std::vector<uint32_t> sorted_ids(1000);
+    for (size_t i = 0; i < sorted_ids.size(); ++i)
+      sorted_ids[i] = static_cast<uint32_t>(1000000 + i * 3 + i % 2);
+    const auto& packed = sorted_ids | _.bitpack;
+    TEST( packed.size(), sorted_ids.size() );
+    TEST( packed[0], 1000000u );
+    TEST( packed[777], sorted_ids[777] );
+    TEST( (packed | _.to_vector), sorted_ids );
+    TEST( packed.compressed_bytes() * 3 < sorted_ids.size() * sizeof(uint32_t), true );
+    const auto& packed_deltas = sorted_ids | _.delta_encode | _.bitpack; // differential coding packs sorted ids tighter
+    TEST( packed_deltas.compressed_bytes() * 5 < sorted_ids.size() * sizeof(uint32_t), true );
+    TEST( (packed_deltas | _.to_vector | _.delta_decode), sorted_ids );
+    TEST( std::vector<uint32_t>(packed.begin(), packed.end()), sorted_ids );
+    const std::vector<int> mixed = {-7, 2147483647, -2147483647 - 1, 0, 5};
+    TEST( (mixed | _.bitpack | _.to_vector), mixed );
+    TEST( (std::vector<uint16_t>(300, 9) | _.bitpack | _.to_vector), std::vector<uint16_t>(300, 9) );
+    TEST( (std::vector<uint32_t>() | _.bitpack).empty(), true );
+    // LZ4 blocks
+    std::string text;
+    for (int i = 0; i < 200; ++i)
+      text += "pipe " + std::to_string(i % 7) + " underscore ";
+    const std::vector<char> block = text | _.lz4_compress;
+    TEST( block.size() * 4 < text.size(), true );
+    TEST( (block | _.lz4_decompress) == std::vector<char>(text.begin(), text.end()), true );
+    TEST( (std::string("abc") | _.lz4_compress | _.lz4_decompress).size(), 3u );
+    TEST( (std::string() | _.lz4_compress | _.lz4_decompress).empty(), true );
+    const char literal_block[] = { 0x30, 'a', 'b', 'c' };
+    TEST( (std::vector<char>(literal_block, literal_block + 4) | _.lz4_decompress).size(), 3u );
+    TEST( (std::vector<char>(literal_block, literal_block + 3) | _.lz4_decompress).empty(), true ); // malformed
+  }
+  // hash, hash_combine
+  {
+    const std::string key = "a somewhat longer key which takes the 48 byte multi lane path of the hash";
+    TEST( (key | _.hash), (UnderscoreDetail::string_ref(key) | _.hash) );
+    TEST( (key | _.hash) != (key | _.hash(1)), true );
+    TEST( (std::string("abc") | _.hash) != (std::string("abd") | _.hash), true );
+    TEST( (std::vector<int>({1, 2}) | _.hash) != (std::vector<int>({2, 1}) | _.hash), true );
+    TEST( (std::list<int>({1, 2, 3}) | _.hash) == (std::list<int>({1, 2, 3}) | _.hash), true );
+    TEST( (std::unordered_set<int>({1, 2, 3, 4}) | _.hash), (std::unordered_set<int>({4, 3, 2, 1}) | _.hash) );
+    TEST( (std::make_pair(std::string("x"), 1) | _.hash) != (std::make_pair(std::string("x"), 2) | _.hash), true );
+    TEST( (std::make_tuple(1, 2.5, std::string("y")) | _.hash), (std::make_tuple(1, 2.5, std::string("y")) | _.hash) );
+    TEST( (-0.0 | _.hash), (0.0 | _.hash) );
+    const size_t combined = std::string("left") | _.hash_combine(std::string("right") | _.hash);
+    TEST( combined != (std::string("right") | _.hash_combine(std::string("left") | _.hash)), true );
+    // Strided integer keys, which all land in one bucket with an identity hash, spread over the buckets
+    std::set<size_t> buckets;
+    for (int i = 0; i < 1000; ++i)
+      buckets.insert((i * 1024) | _.hash | _.pipe([](size_t h) { return h & 1023; }));
+    TEST( buckets.size() > 500, true );
+  }
+  // bloom_filter, cuckoo_filter
+  {
+    std::vector<int> members(5000);
+    for (size_t i = 0; i < members.size(); ++i)
+      members[i] = static_cast<int>(i * 7);
+    const auto& bloom = members | _.to_bloom_filter(0.01);
+    const auto& cuckoo = members | _.to_cuckoo_filter(0.01);
+    TEST( members | _.all_of([&](int m) { return bloom | _.maybe_contains(m); }), true );
+    std::vector<UnderscoreDetail::bloom_filter<int> > copies(3, bloom); // each copy aligns the blocks within its own words
+    copies[0] = copies[2];
+    TEST( members | _.all_of([&](int m) { return copies[0] | _.maybe_contains(m) && copies[2] | _.maybe_contains(m); }), true );
+    TEST( bloom.size_in_bytes() % 64, 0u );
+    const auto moved = std::move(copies[1]);
+    TEST( (copies[1] | _.maybe_contains(members[1])), false ); // moved-from filters stay queryable
+    TEST( (moved | _.maybe_contains(members[1])), true );
+    TEST( members | _.all_of([&](int m) { return cuckoo | _.maybe_contains(m); }), true );
+    TEST( cuckoo.size(), members.size() );
+    size_t bloom_false_positives = 0;
+    size_t cuckoo_false_positives = 0;
+    std::vector<int> strangers;
+    for (int i = 0; i < 20000; ++i)
+      strangers.push_back(i * 7 + 3);
+    for (size_t i = 0; i < strangers.size(); ++i) {
+      bloom_false_positives += bloom.maybe_contains(strangers[i]) ? 1 : 0;
+      cuckoo_false_positives += cuckoo.maybe_contains(strangers[i]) ? 1 : 0;
+    }
+    TEST( bloom_false_positives < strangers.size() / 50, true );
+    TEST( cuckoo_false_positives < strangers.size() / 50, true );
+    // Batch queries agree with single queries
+    const std::vector<bool> bloom_batch = bloom | _.maybe_contains_each(strangers);
+    TEST( std::count(bloom_batch.begin(), bloom_batch.end(), true), static_cast<std::ptrdiff_t>(bloom_false_positives) );
+    const std::vector<bool> cuckoo_batch = cuckoo | _.maybe_contains_each(members);
+    TEST( std::count(cuckoo_batch.begin(), cuckoo_batch.end(), true), static_cast<std::ptrdiff_t>(members.size()) );
+    // Strings, erase and a coarse filter
+    auto words = std::vector<std::string>({"pipe", "tag", "view"}) | _.to_cuckoo_filter(0.05);
+    TEST( (words | _.maybe_contains(std::string("tag"))), true );
+    TEST( (words | _.maybe_contains(UnderscoreDetail::string_ref("view"))), true );
+    TEST( words.erase(std::string("tag")), true );
+    TEST( (words | _.maybe_contains(std::string("tag"))), false );
+    TEST( words.size(), 2u );
+    TEST( (std::vector<std::string>() | _.to_bloom_filter | _.maybe_contains(std::string("x"))), false );
+    // Repeated keys are stored once instead of overflowing their bucket pair
+    const auto& repeated = std::vector<int>(100, 42) | _.to_cuckoo_filter(0.01);
+    TEST( (repeated | _.maybe_contains(42)), true );
+    TEST( repeated.size(), 1u );
+    // Keys sharing a fingerprint each keep a slot, erasing one leaves the others present
+    std::vector<int> distinct(20000);
+    std::iota(distinct.begin(), distinct.end(), 0);
+    auto coarse = distinct | _.to_cuckoo_filter(0.05);
+    TEST( coarse.size(), distinct.size() );
+    for (size_t i = 0; i < distinct.size(); i += 2)
+      coarse.erase(distinct[i]);
+    size_t kept_absent = 0;
+    for (size_t i = 1; i < distinct.size(); i += 2)
+      kept_absent += coarse.maybe_contains(distinct[i]) ? 0 : 1;
+    TEST( kept_absent, 0u );
+  }
+  // group_by, aggregate_by, par_aggregate_by
+  {
+    typedef std::pair<std::string, int> Sale;
+    const std::vector<Sale> sales = {{"oslo", 5}, {"rome", 2}, {"oslo", 1}, {"lima", 7}, {"rome", 4}};
+    const auto& city = [](const Sale& sale) { return sale.first; };
+    const auto& groups = sales | _.group_by(city);
+    TEST( groups.size(), 3u );
+    TEST( groups.at("oslo").size(), 2u );
+    TEST( groups.at("rome").back().second, 4 );
+    const auto& add = [](int total, const Sale& sale) { return total + sale.second; };
+    const auto& totals = sales | _.aggregate_by(city, 0, add);
+    TEST( totals.size(), 3u );
+    TEST( totals.begin()->first, "lima" );
+    TEST( totals.at("oslo"), 6 );
+    TEST( totals.at("rome"), 6 );
+    // Sorted input takes the streaming path and gives the same result
+    const std::vector<Sale> sorted_sales = sales | _.to_vector | _.sort([](const Sale& a, const Sale& b) { return a.first < b.first; });
+    TEST( (sorted_sales | _.aggregate_by(city, 0, add)) == totals, true );
+    std::vector<int> numbers(100000);
+    std::iota(numbers.begin(), numbers.end(), 0);
+    const auto& digit = [](int n) { return n % 10; };
+    const auto& count = [](size_t total, int) { return total + 1; };
+    const auto& combine = [](size_t a, size_t b) { return a + b; };
+    const auto& counts = numbers | _.par_aggregate_by(digit, size_t(0), count, combine);
+    TEST( counts.size(), 10u );
+    TEST( counts.at(3), 10000u );
+    TEST( (counts == (numbers | _.aggregate_by(digit, size_t(0), count))), true );
+  }
+  // hash_join, merge_join
+  {
+    typedef std::pair<int, std::string> Person;
+    typedef std::pair<int, int> Order;
+    const std::vector<Person> people = {{1, "ada"}, {2, "bob"}, {3, "cy"}};
+    const std::vector<Order> orders = {{1, 10}, {3, 30}, {1, 11}, {4, 40}, {1, 12}, {3, 31}, {5, 50}};
+    const auto& person_id = [](const Person& person) { return person.first; };
+    const auto& order_person = [](const Order& order) { return order.first; };
+    const auto& names = [](const std::pair<const Person*, const Order*>& row) {
+      return row.first->second + ":" + (row.second ? std::to_string(row.second->second) : std::string("-"));
+    };
+    typedef std::vector<std::string> Rows;
+    TEST( ((people | _.hash_join(orders, person_id, order_person) | _.transform(names)) == Rows{"ada:10", "cy:30", "ada:11", "ada:12", "cy:31"}), true );
+    TEST( ((people | _.hash_join(orders, person_id, order_person, Underscore::join_kind::left_outer) | _.transform(names)) == Rows{"ada:10", "ada:11", "ada:12", "bob:-", "cy:30", "cy:31"}), true );
+    TEST( ((people | _.hash_join(orders, person_id, order_person, Underscore::join_kind::semi) | _.transform(names)) == Rows{"ada:10", "cy:30"}), true );
+    TEST( ((people | _.hash_join(orders, person_id, order_person, Underscore::join_kind::anti) | _.transform(names)) == Rows{"bob:-"}), true );
+    // Inner joins build on the smaller side and follow the larger input's order, other kinds follow the left input
+    const auto& order_names = orders | _.hash_join(people, order_person, person_id) | _.transform([](const std::pair<const Order*, const Person*>& row) {
+      return row.second->second + ":" + std::to_string(row.first->second);
+    });
+    TEST( (order_names == Rows{"ada:10", "cy:30", "ada:11", "ada:12", "cy:31"}), true );
+    const auto& sorted_orders = orders | _.to_vector | _.sort([](const Order& a, const Order& b) { return a.first < b.first; });
+    TEST( ((people | _.merge_join(sorted_orders, person_id, order_person) | _.transform(names)) == Rows{"ada:10", "ada:11", "ada:12", "cy:30", "cy:31"}), true );
+    TEST( ((people | _.merge_join(sorted_orders, person_id, order_person, Underscore::join_kind::left_outer) | _.transform(names)) == Rows{"ada:10", "ada:11", "ada:12", "bob:-", "cy:30", "cy:31"}), true );
+    TEST( ((people | _.merge_join(sorted_orders, person_id, order_person, Underscore::join_kind::semi) | _.transform(names)) == Rows{"ada:10", "cy:30"}), true );
+    TEST( ((people | _.merge_join(sorted_orders, person_id, order_person, Underscore::join_kind::anti) | _.transform(names)) == Rows{"bob:-"}), true );
+    const std::vector<Person> nobody; // joins point into their inputs, so temporaries are refused
+    TEST( (nobody | _.merge_join(sorted_orders, person_id, order_person)).empty(), true );
+  }
+  // partition_by, par_each_partition
+  {
+    std::vector<int> numbers(100000);
+    std::iota(numbers.begin(), numbers.end(), 0);
+    const auto& identity = [](int n) { return static_cast<size_t>(n); };
+    auto partitions = numbers | _.partition_by(identity, 8);
+    TEST( partitions.partition_count(), 8u );
+    TEST( partitions.size(), numbers.size() );
+    TEST( partitions.partition(3).size(), 12500u );
+    TEST( partitions.partition(3)[1], 11 );
+    TEST( (partitions.partition(3) | _.all_of([](int n) { return n % 8 == 3; })), true );
+    TEST( (partitions.partition(3) | _.is_sorted), true );
+    // Each partition is owned by one thread, so it can be modified without locks
+    std::vector<size_t> sums(7);
+    const auto& summed = numbers | _.partition_by(identity, 7) | _.par_each_partition([&](UnderscoreDetail::partition_range<int> partition) {
+      std::sort(partition.begin(), partition.end(), std::greater<int>());
+      sums[partition.index()] = std::accumulate(partition.begin(), partition.end(), size_t(0));
+    });
+    TEST( summed.partition(0).front(), 99995 );
+    TEST( std::accumulate(sums.begin(), sums.end(), size_t(0)), size_t(99999) * 100000 / 2 );
+    // An l-value is modified in place rather than through a copy
+    partitions | _.par_each_partition([](UnderscoreDetail::partition_range<int> partition) { std::reverse(partition.begin(), partition.end()); });
+    TEST( partitions.partition(3)[0], 99995 );
+    TEST( (&(partitions | _.par_each_partition([](UnderscoreDetail::partition_range<int>) {})) == &partitions), true );
+    const std::vector<std::string> words = {"pear", "fig", "apple", "kiwi", "plum", "lime"};
+    const auto& by_length = words | _.partition_by([](const std::string& word) { return word.size(); }, 3);
+    TEST( (by_length.partition(1) | _.to_vector) == std::vector<std::string>({"pear", "kiwi", "plum", "lime"}), true );
+    TEST( by_length.partition(2).front(), "apple" );
+  }
+  // inclusive_scan, exclusive_scan, transform_scan
+  {
+    const std::vector<int> counts = {3, 1, 4, 1, 5, 9, 2};
+    TEST( (counts | _.inclusive_scan) == std::vector<int>({3, 4, 8, 9, 14, 23, 25}), true );
+    TEST( (counts | _.exclusive_scan(0)) == std::vector<int>({0, 3, 4, 8, 9, 14, 23}), true );
+    TEST( (counts | _.exclusive_scan(size_t(10))).back(), 33u );
+    TEST( (counts | _.inclusive_scan([](int a, int b) { return std::max(a, b); })) == std::vector<int>({3, 3, 4, 4, 5, 9, 9}), true );
+    TEST( (counts | _.exclusive_scan(1, std::multiplies<int>())) == std::vector<int>({1, 3, 3, 12, 12, 60, 540}), true );
+    const std::vector<std::string> words = {"a", "bc", "def"};
+    const auto& length = [](const std::string& word) { return word.size(); };
+    TEST( (words | _.transform_scan(length, std::plus<size_t>())) == std::vector<size_t>({1, 3, 6}), true );
+    TEST( (std::list<int>{1, 2, 3} | _.inclusive_scan) == std::vector<int>({1, 3, 6}), true );
+    TEST( (std::vector<int>() | _.inclusive_scan).empty(), true );
+    // The parallel scans match the serial ones
+    std::vector<int64_t> values(200003);
+    for (size_t i = 0; i < values.size(); ++i)
+      values[i] = static_cast<int64_t>(i % 13) - 6;
+    const auto& sums = values | _.inclusive_scan;
+    TEST( (sums == (values | _.par_inclusive_scan)), true );
+    TEST( (sums == (values | _.par_inclusive_scan(std::plus<int64_t>()))), true );
+    TEST( ((values | _.exclusive_scan(int64_t(5))) == (values | _.par_exclusive_scan(int64_t(5)))), true );
+    TEST( (values | _.exclusive_scan(int64_t(5)))[1000], sums[999] + 5 );
+    const auto& absolute = [](int64_t value) { return value < 0 ? -value : value; };
+    TEST( ((values | _.transform_scan(absolute, std::plus<int64_t>())) == (values | _.par_transform_scan(absolute, std::plus<int64_t>()))), true );
+    std::vector<uint32_t> offsets(100001, 2);
+    TEST( (offsets | _.par_exclusive_scan(uint32_t(0))).back(), 200000u );
+  }
+  // copy_if, par_copy_if, erase_all_if
+  {
+    std::vector<float> samples(300007);
+    for (size_t i = 0; i < samples.size(); ++i)
+      samples[i] = static_cast<float>((i * 7919) % 1000) / 1000.0f;
+    const auto& above = [](float sample) { return sample > 0.75f; };
+    const auto& kept = samples | _.copy_if(above);
+    TEST( kept.size(), static_cast<size_t>(std::count_if(samples.begin(), samples.end(), above)) );
+    TEST( kept.capacity(), kept.size() );
+    TEST( (kept == (samples | _.par_copy_if(above))), true );
+    TEST( (kept | _.all_of(above)), true );
+    TEST( (std::list<int>{1, 2, 3, 4} | _.copy_if([](int n) { return n % 2 == 0; })) == std::vector<int>({2, 4}), true );
+    // The output container keeps its storage, longer ones are trimmed and shorter ones grow
+    std::vector<float> buffer(400000);
+    const float* storage = buffer.data();
+    buffer = samples | _.copy_if(above, buffer);
+    TEST( (buffer == kept), true );
+    TEST( buffer.data() == storage, true );
+    std::list<int> out_list = {9};
+    const auto& evens = std::vector<int>{1, 2, 3, 4, 6} | _.copy_if([](int n) { return n % 2 == 0; }, out_list);
+    TEST( (evens == std::list<int>{2, 4, 6}), true );
+    std::list<int> long_list = {9, 9, 9, 9};
+    TEST( (std::vector<int>{1, 2} | _.copy_if([](int n) { return n > 1; }, long_list)) == std::list<int>{2}, true );
+    // Elements without a default constructor are appended rather than resized into
+    struct Reading { explicit Reading(int value) : value(value) {} int value; };
+    std::vector<Reading> readings;
+    for (int i = 0; i < 100000; ++i)
+      readings.push_back(Reading(i));
+    const auto& odd = [](const Reading& reading) { return reading.value % 2 == 1; };
+    TEST( (readings | _.copy_if(odd)).size(), 50000u );
+    TEST( (readings | _.par_copy_if(odd)).size(), 50000u );
+    TEST( (readings | _.par_copy_if(odd)).back().value, 99999 );
+    TEST( (samples | _.erase_all_if([](float sample) { return sample <= 0.75f; })) == kept, true );
+    TEST( (std::string("a-b-c") | _.erase_all_if([](char c) { return c == '-'; })), "abc" );
+  }
+  // transform_into, transform_inplace, par_transform
+  {
+    std::vector<float> positions(70001);
+    std::iota(positions.begin(), positions.end(), 0.0f);
+    const auto& scale = [](float position) { return position * 2.0f; };
+    std::vector<float> scaled;
+    scaled.reserve(positions.size());
+    const float* storage = scaled.data();
+    positions | _.transform_into(scale, scaled);
+    TEST( scaled.size(), positions.size() );
+    TEST( scaled.data() == storage, true );
+    TEST( scaled.back(), 140000.0f );
+    // A shorter input shrinks the size but keeps the storage, the result can be piped on as a mutable container
+    TEST( (_.array(3.0f, 1.0f, 2.0f) | _.to_vector | _.transform_into(scale, scaled) | _.sort | _.front), 2.0f );
+    TEST( (scaled == std::vector<float>({2.0f, 4.0f, 6.0f})), true );
+    TEST( scaled.data() == storage, true );
+    positions | _.par_transform_into(scale, scaled);
+    TEST( (scaled == (positions | _.transform(scale))), true );
+    TEST( ((positions | _.par_transform(scale)) == scaled), true );
+    TEST( ((positions | _.par_transform([](float position) { return static_cast<int>(position); })) | _.back), 70000 );
+    std::vector<float> moved = positions;
+    _[moved] | _.transform_inplace(scale);
+    TEST( (moved == scaled), true );
+    _[moved] | _.par_transform_inplace([](float position) { return position + 1.0f; });
+    TEST( moved[10], 21.0f );
+    TEST( (std::list<int>{1, 2} | _.transform_inplace([](int n) { return -n; })) == std::list<int>({-1, -2}), true );
+  }
+  // lower_bound, upper_bound, binary_search, to_eytzinger, lower_bound_batch
+  {
+    std::vector<int> rates(1000);
+    for (size_t i = 0; i < rates.size(); ++i)
+      rates[i] = static_cast<int>(i / 2) * 3;
+    TEST( (rates | _.lower_bound(30)) - rates.begin(), 20 );
+    TEST( (rates | _.upper_bound(30)) - rates.begin(), 22 );
+    TEST( (rates | _.lower_bound(31)) - rates.begin(), 22 );
+    TEST( (rates | _.lower_bound(5000)) == rates.end(), true );
+    TEST( (rates | _.binary_search(30)), true );
+    TEST( (rates | _.binary_search(31)), false );
+    TEST( (std::list<int>{1, 3, 5} | _.binary_search(3)), true );
+    const auto& tree = rates | _.to_eytzinger;
+    TEST( tree.size(), rates.size() );
+    TEST( *(tree | _.lower_bound(31)), 33 );
+    TEST( *(tree | _.upper_bound(33)), 36 );
+    TEST( (tree | _.lower_bound(-1)) == tree.end(), false );
+    TEST( *(tree | _.lower_bound(-1)), 0 );
+    TEST( (tree | _.lower_bound(1498)) == tree.end(), true );
+    TEST( (tree | _.binary_search(1497)), true );
+    TEST( (tree | _.binary_search(1496)), false );
+    TEST( (_.array(5, 1, 3) | _.to_vector | _.to_eytzinger | _.binary_search(3)), true );
+    std::vector<int> queries;
+    for (int query = -2; query < 1510; query += 7)
+      queries.push_back(query);
+    const auto& positions = rates | _.lower_bound_batch(queries);
+    const auto& nodes = tree | _.lower_bound_batch(queries);
+    TEST( positions.size(), queries.size() );
+    bool batch_matches = true;
+    for (size_t i = 0; i < queries.size(); ++i) {
+      const auto& expected = std::lower_bound(rates.begin(), rates.end(), queries[i]);
+      batch_matches = batch_matches && positions[i] == expected;
+      batch_matches = batch_matches && (nodes[i] == tree.end() ? expected == rates.end() : *nodes[i] == *expected);
+    }
+    TEST( batch_matches, true );
+    TEST( (std::vector<int>() | _.lower_bound_batch(queries)).size(), queries.size() );
+  }
+  // interpolation_search, exponential_search
+  {
+    std::vector<int64_t> timestamps(5000);
+    for (size_t i = 0; i < timestamps.size(); ++i)
+      timestamps[i] = 1000000 + static_cast<int64_t>(i) * 250 + static_cast<int64_t>(i % 7);
+    TEST( (timestamps | _.interpolation_search(timestamps[1234])) - timestamps.begin(), 1234 );
+    TEST( (timestamps | _.interpolation_search(timestamps[1234] + 1)) - timestamps.begin(), 1235 );
+    TEST( (timestamps | _.interpolation_search(int64_t(0))) == timestamps.begin(), true );
+    TEST( (timestamps | _.interpolation_search(int64_t(1) << 40)) == timestamps.end(), true );
+    // Skewed keys fall back to bisection
+    const std::vector<double> skewed = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 1e9, 2e9};
+    TEST( (skewed | _.interpolation_search(19.5)) - skewed.begin(), 19 );
+    TEST( (timestamps | _.exponential_search(timestamps[2000], 1990)) - timestamps.begin(), 2000 );
+    TEST( (timestamps | _.exponential_search(timestamps[2000], 2100)) - timestamps.begin(), 2000 );
+    TEST( (timestamps | _.exponential_search(timestamps[2000], timestamps.begin() + 2000)) - timestamps.begin(), 2000 );
+    TEST( (timestamps | _.exponential_search(int64_t(0), timestamps.size())) == timestamps.begin(), true );
+    TEST( (timestamps | _.exponential_search(int64_t(1) << 40, 0)) == timestamps.end(), true );
+  }
   // String handling
   {
     {
@@ -227,6 +980,14 @@ void run_underscore_test() {
     TEST(tokens2.size(), 0);
     const auto& tokens3 = _.str << "11131" | _.tokenize_string(_.str << "1");
     TEST(tokens3.size(), 1);
+    const auto& tokens4 = sstr | _.tokenize_string("43").into<Underscore::small_vector<std::string, 4> >();
+    TEST(tokens4.size(), 3);
+    TEST(tokens4.is_inline(), true);
+    TEST(tokens4.at(1), std::string("5"));
+#if __cplusplus >= 201703L
+    const auto& tokens5 = sstr | _.tokenize_string("43").into<Underscore::small_vector<std::string_view, 16> >();
+    TEST(tokens5.back(), std::string_view("21"));
+#endif
     
     // 
     std::wstring wstrTest = L"ABC";